@@ -0,0 +1,401 @@
+#include "Bench.h"
+#include "Cpu.h"
+#include "Minimax.h"
+#include "Nnue.h"
+#include "Pawns.h"
+#include "See.h"
+
+#include <algorithm> // for std::find
+#include <chrono>
+#include <cstdio>    // for std::snprintf
+#include <cstdlib>   // for std::abs
+#include <iostream>
+#include <random>
+
+// Middlegame-heavy positions (tactical ones first) plus a few endgames
+static const char* const BENCH_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+    "r2q1rk1/pp2ppbp/2p2np1/6B1/3PP1b1/Q1P2N2/P4PPP/3RKB1R b K - 0 13",
+    "r1bq1rk1/pp1nbppp/2p1pn2/3p4/2PP4/2NBPN2/PP3PPP/R1BQ1RK1 w - - 0 8",
+    "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+    "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+    "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+    "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/pp3pk1/2p3p1/4P3/5P2/6K1/PP6/8 w - - 0 1",
+    "8/8/3k4/8/8/8/8/2N1KN2 w - - 0 1",
+};
+
+void runBench(int depth, const EvalParameters& evalParams) {
+    uint64_t totalNodes = 0;
+    uint64_t totalTries = 0;
+    uint64_t totalCuts = 0;
+    uint64_t totalProbes = 0;
+    uint64_t totalHits = 0;
+    EvalTierStats tiers = {};
+    const PawnTable& pawns = pawnTable();
+    uint64_t pawnProbes = pawns.probes;
+    uint64_t pawnHits = pawns.hits;
+
+    auto start = std::chrono::steady_clock::now();
+
+    int index = 0;
+    for (const char* fen : BENCH_POSITIONS) {
+        index++;
+        Board b;
+        if (!b.loadFEN(fen)) {
+            std::cout << "Position " << index << ": bad FEN, skipped\n";
+            continue;
+        }
+
+        // Every position starts from an empty table so runs are reproducible
+        clearTranspositionTable();
+        Move best = findBestMove(b, depth, evalParams);
+        const SearchStats& stats = lastSearchStats();
+
+        std::cout << "Position " << index << ": best " << moveToString(best)
+            << "  nodes " << stats.nodes
+            << "  probcut " << stats.probCutCuts << "/" << stats.probCutTries << "\n";
+
+        totalNodes += stats.nodes;
+        totalTries += stats.probCutTries;
+        totalCuts += stats.probCutCuts;
+        totalProbes += stats.evalCacheProbes;
+        totalHits += stats.evalCacheHits;
+        tiers.evaluations += stats.evalTiers.evaluations;
+        for (int t = 0; t < EVAL_TIER_COUNT; t++) {
+            tiers.skipped[t] += stats.evalTiers.skipped[t];
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "==========================\n"
+        << "Evaluation      : " << (useNnue() ? "NNUE" : "classical") << "\n"
+        << "Total time (ms) : " << elapsed << "\n"
+        << "Nodes searched  : " << totalNodes << "\n"
+        << "Nodes/second    : " << (totalNodes * 1000 / (elapsed > 0 ? elapsed : 1)) << "\n"
+        << "ProbCut cuts    : " << totalCuts << "/" << totalTries << "\n"
+        << "Eval cache hits : " << totalHits << "/" << totalProbes << " ("
+        << (totalProbes ? totalHits * 100 / totalProbes : 0) << "%)\n";
+
+    // Lazy evaluation and the pawn table only concern the classical evaluation
+    if (tiers.evaluations) {
+        std::cout << "Lazy eval skips : " << tiers.evaluations << " evaluations, piece tier skipped "
+            << tiers.skipped[EVAL_TIER_PIECES] * 100 / tiers.evaluations << "%\n";
+    }
+    pawnProbes = pawns.probes - pawnProbes;
+    pawnHits = pawns.hits - pawnHits;
+    if (pawnProbes) {
+        std::cout << "Pawn table hits : " << pawnHits << "/" << pawnProbes << " ("
+            << pawnHits * 100 / pawnProbes << "%)\n";
+    }
+}
+
+void runSeeBench(const EvalParameters& evalParams) {
+    // Positions are copied with their capture lists, so the timed loops only
+    // run the exchange evaluation itself
+    struct Sample {
+        Board board;
+        MoveList captures;
+    };
+    std::vector<Sample> samples;
+    size_t captureCount = 0;
+
+    auto addSample = [&](const Board& b) {
+        Sample s;
+        s.board = b;
+        b.generateMoves(CAPTURES, s.captures);
+        if (!s.captures.empty()) {
+            captureCount += s.captures.size();
+            samples.push_back(s);
+        }
+    };
+
+    for (const char* fen : BENCH_POSITIONS) {
+        Board b;
+        if (!b.loadFEN(fen)) continue;
+        addSample(b);
+        for (const auto& m : b.generateLegalMoves()) {
+            b.makeMove(m);
+            addSample(b);
+            b.undoMove(m);
+        }
+    }
+
+    const int ROUNDS = 200;
+    long long checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUNDS; i++) {
+        for (const auto& s : samples) {
+            for (const auto& m : s.captures) {
+                checksum += see(s.board, m, evalParams);
+            }
+        }
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUNDS; i++) {
+        for (const auto& s : samples) {
+            for (const auto& m : s.captures) {
+                checksum += seeGE(s.board, m, 0, evalParams);
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double calls = static_cast<double>(captureCount) * ROUNDS;
+    double seeNs = std::chrono::duration<double, std::nano>(middle - start).count() / calls;
+    double seeGENs = std::chrono::duration<double, std::nano>(end - middle).count() / calls;
+
+    std::cout << "Captures        : " << captureCount << " in " << samples.size() << " positions\n"
+        << "see()   ns/call : " << seeNs << "\n"
+        << "seeGE() ns/call : " << seeGENs << "\n"
+        << "Checksum        : " << checksum << "\n";
+}
+
+uint64_t perft(Board& b, int depth) {
+    MoveList moves;
+    b.generateMoves(LEGAL, moves);
+    if (depth <= 1) {
+        return (depth == 1) ? moves.size() : 1;
+    }
+
+    uint64_t nodes = 0;
+    for (const auto& m : moves) {
+        b.makeMove(m);
+        nodes += perft(b, depth - 1);
+        b.undoMove(m);
+    }
+    return nodes;
+}
+
+void runPerft(int depth, const std::string& fen) {
+    Board b;
+    if (!fen.empty() && !b.loadFEN(fen)) {
+        std::cout << "Bad FEN: " << fen << "\n";
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t total = 0;
+    for (const auto& m : b.generateLegalMoves()) {
+        b.makeMove(m);
+        uint64_t nodes = (depth > 1) ? perft(b, depth - 1) : 1;
+        b.undoMove(m);
+
+        std::string name = moveToString(m);
+        if (m.promotion != EMPTY) {
+            name += " pnbrqk"[m.promotion];
+        }
+        std::cout << name << ": " << nodes << "\n";
+        total += nodes;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "==========================\n"
+        << "Nodes           : " << total << "\n"
+        << "Total time (ms) : " << elapsed << "\n"
+        << "Nodes/second    : " << (total * 1000 / (elapsed > 0 ? elapsed : 1)) << "\n";
+}
+
+// Centipawns as pawns with a sign ("+0.35"), or a mate as "#3" / "#-3"
+// (moves, not plies), from White's point of view
+static std::string scoreToString(int score) {
+    if (isMateScore(score)) {
+        int moves = (MATE_SCORE - std::abs(score) + 1) / 2;
+        return (score > 0) ? "#" + std::to_string(moves) : "#-" + std::to_string(moves);
+    }
+    char text[16];
+    std::snprintf(text, sizeof(text), "%+.2f", score / 100.0);
+    return text;
+}
+
+void runAnalysis(int depth, int multiPV, const std::string& fen, const EvalParameters& evalParams) {
+    Board b;
+    if (!fen.empty() && !b.loadFEN(fen)) {
+        std::cout << "Bad FEN: " << fen << "\n";
+        return;
+    }
+
+    clearTranspositionTable();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SearchLine> lines = searchMultiPV(b, depth, multiPV, evalParams);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    if (lines.empty()) {
+        std::cout << "No legal moves\n";
+        return;
+    }
+
+    // Scores are from White's point of view; the side to move ranks them
+    int sign = (b.sideToMove == WHITE) ? 1 : -1;
+    bool ranked = true;
+    bool legal = true;
+    for (size_t i = 0; i < lines.size(); i++) {
+        const SearchLine& line = lines[i];
+        if (i > 0 && sign * line.score > sign * lines[i - 1].score) {
+            ranked = false;
+        }
+
+        // Play the PV on a copy to print it and to check every move
+        Board pvBoard = b;
+        std::string pv;
+        for (const Move& m : line.pv) {
+            std::vector<Move> moves = pvBoard.generateLegalMoves();
+            auto it = std::find(moves.begin(), moves.end(), m);
+            if (it == moves.end()) {
+                legal = false;
+                pv += (pv.empty() ? "(illegal " : " (illegal ") + moveToString(m) + ")";
+                break;
+            }
+            pv += (pv.empty() ? "" : " ") + moveToString(*it);
+            if (it->promotion != EMPTY) {
+                pv += " pnbrqk"[it->promotion];
+            }
+            pvBoard.makeMove(*it);
+        }
+        if (line.pv.empty() || !(line.pv[0] == line.move)) {
+            legal = false;
+        }
+        std::cout << (i + 1) << ". " << scoreToString(line.score) << "  " << pv << "\n";
+    }
+
+    uint64_t nodes = lastSearchStats().nodes;
+    std::cout << "==========================\n"
+        << "Depth           : " << depth << "\n"
+        << "Nodes searched  : " << nodes << "\n"
+        << "Total time (ms) : " << elapsed << "\n"
+        << "Nodes/second    : " << (nodes * 1000 / (elapsed > 0 ? elapsed : 1)) << "\n";
+    if (!ranked) {
+        std::cout << "WARNING: lines are not ranked best first\n";
+    }
+    if (!legal) {
+        std::cout << "WARNING: a PV does not start with its move or holds an illegal move\n";
+    }
+}
+
+bool runCpuBench() {
+    std::cout << "CPU features    : " << cpuFeatureString() << "\n";
+    bool ok = runCpuSelfTest();
+
+    // Kiwipete exercises every slider and special move
+    Board b;
+    b.loadFEN("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+    auto timePerft = [&](const char* label, bool useExtensions) {
+        selectCpuPaths(useExtensions);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = perft(b, 5);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << label << nodes << " nodes in " << elapsed << " ms ("
+            << (nodes * 1000 / (elapsed > 0 ? elapsed : 1)) << " nps)\n";
+    };
+
+    timePerft("Portable        : ", false);
+    timePerft("Dispatched      : ", true);
+    return ok;
+}
+
+template <typename T>
+static void fillRandom(std::vector<T>& v, int range, std::mt19937& rng) {
+    for (auto& x : v) x = static_cast<T>(static_cast<int>(rng() % (2 * range + 1)) - range);
+}
+
+// Random weights in the network's ranges, for timing without a trained file.
+// About half the first-layer outputs end up clipped to zero.
+static NnueNetwork randomNetwork() {
+    std::mt19937 rng(5);
+    NnueNetwork net;
+    net.ftBiases.resize(NNUE_L1);
+    net.ftWeights.resize(static_cast<size_t>(NNUE_INPUTS) * NNUE_L1);
+    net.l2Biases.resize(NNUE_L2);
+    net.l2Weights.resize(NNUE_L2 * 2 * NNUE_L1);
+    net.l3Biases.resize(NNUE_L3);
+    net.l3Weights.resize(NNUE_L3 * NNUE_L2);
+    net.outWeights.resize(NNUE_L3);
+    fillRandom(net.ftBiases, 20, rng);
+    fillRandom(net.ftWeights, 20, rng);
+    fillRandom(net.l2Biases, 2000, rng);
+    fillRandom(net.l2Weights, 60, rng);
+    fillRandom(net.l3Biases, 2000, rng);
+    fillRandom(net.l3Weights, 60, rng);
+    fillRandom(net.outWeights, 60, rng);
+    net.outBias = 0;
+    return net;
+}
+
+void runNnueBench() {
+    if (!networkLoaded()) {
+        std::cout << "No network loaded, timing random weights\n";
+        setNetwork(randomNetwork());
+    }
+
+    // The bench positions and every position one move later, with their
+    // accumulators computed, so the first loop times only the layers after
+    // the accumulator
+    std::vector<Board> boards;
+    for (const char* fen : BENCH_POSITIONS) {
+        Board b;
+        if (!b.loadFEN(fen)) continue;
+        boards.push_back(b);
+        for (const auto& m : b.generateLegalMoves()) {
+            b.makeMove(m);
+            boards.push_back(b);
+            b.undoMove(m);
+        }
+    }
+    for (const auto& b : boards) {
+        nnueEvaluate(b);
+    }
+
+    const int ROUNDS = 200;
+    NnuePath selected = nnuePath();
+    for (int p = NNUE_PORTABLE; p < NNUE_PATH_COUNT; p++) {
+        NnuePath path = static_cast<NnuePath>(p);
+        std::string label = nnuePathName(path);
+        label.resize(16, ' ');
+        if (!setNnuePath(path)) {
+            std::cout << label << ": not supported\n";
+            continue;
+        }
+
+        long long checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < ROUNDS; i++) {
+            for (const auto& b : boards) {
+                checksum += nnueEvaluate(b);
+            }
+        }
+        auto middle = std::chrono::steady_clock::now();
+
+        // Make, evaluate, undo: adds the incremental accumulator update
+        uint64_t moveCount = 0;
+        for (int i = 0; i < ROUNDS / 20; i++) {
+            for (auto& b : boards) {
+                for (const auto& m : b.generateLegalMoves()) {
+                    b.makeMove(m);
+                    checksum += nnueEvaluate(b);
+                    b.undoMove(m);
+                    moveCount++;
+                }
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double layersNs = std::chrono::duration<double, std::nano>(middle - start).count()
+            / (static_cast<double>(boards.size()) * ROUNDS);
+        double moveNs = std::chrono::duration<double, std::nano>(end - middle).count()
+            / static_cast<double>(moveCount);
+        std::cout << label << ": " << layersNs << " ns/eval, " << moveNs
+            << " ns/move+eval (checksum " << checksum << ")\n";
+    }
+    setNnuePath(selected);
+}
@@ -0,0 +1,40 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "Evaluation.h" // we need EvalParameters
+
+#include <cstdint>
+#include <string>
+
+// Fixed-depth search over a fixed set of positions, printing nodes, time and
+// nodes per second. Run it before and after a search change (e.g. a different
+// ProbCut margin) and compare the totals.
+void runBench(int depth, const EvalParameters& evalParams);
+
+// Times see() and seeGE() over the captures of the bench positions (and of
+// the positions one move later), printing nanoseconds per call
+void runSeeBench(const EvalParameters& evalParams);
+
+// Number of leaf nodes of the legal move tree (move generator validation)
+uint64_t perft(Board& b, int depth);
+
+// Perft with a per-root-move breakdown, total, time and NPS.
+// An empty FEN means the starting position.
+void runPerft(int depth, const std::string& fen);
+
+// MultiPV analysis of one position (empty FEN: the starting position):
+// the best 'multiPV' lines at 'depth', each with its rank, score and PV,
+// and a warning if they are not ranked best first or a PV is not legal
+void runAnalysis(int depth, int multiPV, const std::string& fen, const EvalParameters& evalParams);
+
+// Prints the detected CPU features, runs the dispatch self-test and times
+// perft with the portable paths and with the ones picked for this CPU.
+// Returns false if the self-test failed.
+bool runCpuBench();
+
+// Times the NNUE evaluation on every path this CPU supports: the layers
+// after an up-to-date accumulator, and make + evaluate + undo. Uses random
+// weights when no network is loaded. Equal checksums mean equal results.
+void runNnueBench();
+
+#endif // BENCH_H
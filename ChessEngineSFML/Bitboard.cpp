@@ -0,0 +1,188 @@
+#include "Bitboard.h"
+#include "Cpu.h"
+
+#include <vector>
+
+#if CPU_X86_64
+#include <immintrin.h>
+#endif
+
+// Row/column step of each Direction
+static constexpr int DIRECTION_STEPS[DIRECTION_COUNT][2] = {
+    {1,0}, {0,1}, {1,1}, {1,-1},
+    {-1,0}, {0,-1}, {-1,-1}, {-1,1}
+};
+
+static constexpr int KNIGHT_OFFSETS[8][2] = {
+    {2,1},{2,-1},{-2,1},{-2,-1},
+    {1,2},{1,-2},{-1,2},{-1,-2}
+};
+
+static constexpr bool onBoard(int r, int c) {
+    return r >= 0 && r < 8 && c >= 0 && c < 8;
+}
+
+constexpr LeaperAttacks::LeaperAttacks() : pawn(), knight(), king() {
+    for (int sq = 0; sq < 64; sq++) {
+        int r = rowOf(sq);
+        int c = colOf(sq);
+
+        for (int dc = -1; dc <= 1; dc += 2) {
+            if (onBoard(r + 1, c + dc)) pawn[WHITE][sq] |= squareBB(squareOf(r + 1, c + dc));
+            if (onBoard(r - 1, c + dc)) pawn[BLACK][sq] |= squareBB(squareOf(r - 1, c + dc));
+        }
+
+        for (const auto& off : KNIGHT_OFFSETS) {
+            if (onBoard(r + off[0], c + off[1])) {
+                knight[sq] |= squareBB(squareOf(r + off[0], c + off[1]));
+            }
+        }
+
+        for (const auto& step : DIRECTION_STEPS) {
+            if (onBoard(r + step[0], c + step[1])) {
+                king[sq] |= squareBB(squareOf(r + step[0], c + step[1]));
+            }
+        }
+    }
+}
+
+// Walk every ray; each square on it gets its 'between' entry on the way
+constexpr RayMasks::RayMasks() : ray(), between() {
+    for (int sq = 0; sq < 64; sq++) {
+        for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+            int dr = DIRECTION_STEPS[dir][0];
+            int dc = DIRECTION_STEPS[dir][1];
+            Bitboard path = 0;
+            for (int r = rowOf(sq) + dr, c = colOf(sq) + dc; onBoard(r, c); r += dr, c += dc) {
+                int to = squareOf(r, c);
+                ray[dir][sq] |= squareBB(to);
+                between[sq][to] = path;
+                path |= squareBB(to);
+            }
+        }
+    }
+}
+
+constexpr RayMasks rayMasks;
+
+// A line is both rays through the two squares plus the squares themselves
+constexpr LineMasks::LineMasks() : line() {
+    for (int sq = 0; sq < 64; sq++) {
+        for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+            int opposite = (dir + 4) % DIRECTION_COUNT;
+            Bitboard full = rayMasks.ray[dir][sq] | rayMasks.ray[opposite][sq] | squareBB(sq);
+            Bitboard targets = rayMasks.ray[dir][sq];
+            while (targets) {
+                line[sq][popLsb(targets)] = full;
+            }
+        }
+    }
+}
+
+constexpr SquareDistances::SquareDistances() : distance() {
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            int dr = rowOf(a) - rowOf(b);
+            int dc = colOf(a) - colOf(b);
+            dr = (dr < 0) ? -dr : dr;
+            dc = (dc < 0) ? -dc : dc;
+            distance[a][b] = static_cast<uint8_t>((dr > dc) ? dr : dc);
+        }
+    }
+}
+
+constexpr LeaperAttacks leaperAttacks;
+constexpr LineMasks lineMasks;
+constexpr SquareDistances squareDistances;
+
+// Spot checks, evaluated by the compiler
+static_assert(leaperAttacks.knight[0] == (squareBB(10) | squareBB(17)), "knight on a1");
+static_assert(leaperAttacks.king[63] == (squareBB(54) | squareBB(55) | squareBB(62)), "king on h8");
+static_assert(rayMasks.between[0][63] == 0x0040201008040200ULL, "a1-h8 diagonal");
+static_assert(lineMasks.line[0][9] == 0x8040201008040201ULL, "long diagonal");
+static_assert(squareDistances.distance[0][63] == 7 && squareDistances.distance[9][18] == 1, "distance");
+
+// --------------------------------------------------
+// PEXT slider tables
+// --------------------------------------------------
+SliderPath sliderPath = SLIDER_RAYS;
+
+// Per square: the relevant occupancy mask (the rays without their last
+// square, which can never hide anything) and where its attacks start in
+// the shared table; 2^popCount(mask) entries follow
+struct PextSlider {
+    Bitboard mask[64];
+    int offset[64];
+    std::vector<Bitboard> attacks;
+};
+
+static PextSlider pextRook;
+static PextSlider pextBishop;
+
+// Software PDEP: spreads the low bits of 'index' over the set bits of 'mask'
+static Bitboard depositBits(uint64_t index, Bitboard mask) {
+    Bitboard result = 0;
+    for (int i = 0; mask; i++) {
+        int sq = popLsb(mask);
+        if (index & (1ULL << i)) result |= squareBB(sq);
+    }
+    return result;
+}
+
+static void initPextSlider(PextSlider& slider, const Direction dirs[4], Bitboard (*attacks)(int, Bitboard)) {
+    int size = 0;
+    for (int sq = 0; sq < 64; sq++) {
+        Bitboard mask = 0;
+        for (int i = 0; i < 4; i++) {
+            Bitboard ray = rayMasks.ray[dirs[i]][sq];
+            if (ray) {
+                int last = (dirs[i] < SOUTH) ? msb(ray) : lsb(ray);
+                mask |= ray ^ squareBB(last);
+            }
+        }
+        slider.mask[sq] = mask;
+        slider.offset[sq] = size;
+        size += 1 << popCount(mask);
+    }
+
+    // Index i of a square's block holds the attacks for the occupancy whose
+    // PEXT under the mask is i
+    slider.attacks.assign(size, 0);
+    for (int sq = 0; sq < 64; sq++) {
+        int count = 1 << popCount(slider.mask[sq]);
+        for (int i = 0; i < count; i++) {
+            slider.attacks[slider.offset[sq] + i] = attacks(sq, depositBits(i, slider.mask[sq]));
+        }
+    }
+}
+
+void initPextSliders() {
+    static const Direction rookDirs[4] = { NORTH, EAST, SOUTH, WEST };
+    static const Direction bishopDirs[4] = { NORTH_EAST, NORTH_WEST, SOUTH_EAST, SOUTH_WEST };
+    if (pextRook.attacks.empty()) {
+        initPextSlider(pextRook, rookDirs, rayRookAttacks);
+        initPextSlider(pextBishop, bishopDirs, rayBishopAttacks);
+    }
+}
+
+#if CPU_X86_64
+TARGET_BMI2 static inline uint64_t pext(Bitboard b, Bitboard mask) {
+    return _pext_u64(b, mask);
+}
+#else
+static inline uint64_t pext(Bitboard b, Bitboard mask) {
+    uint64_t result = 0;
+    for (int i = 0; mask; i++) {
+        if (b & squareBB(popLsb(mask))) result |= 1ULL << i;
+    }
+    return result;
+}
+#endif
+
+TARGET_BMI2 Bitboard pextRookAttacks(int sq, Bitboard occupied) {
+    return pextRook.attacks[pextRook.offset[sq] + pext(occupied, pextRook.mask[sq])];
+}
+
+TARGET_BMI2 Bitboard pextBishopAttacks(int sq, Bitboard occupied) {
+    return pextBishop.attacks[pextBishop.offset[sq] + pext(occupied, pextBishop.mask[sq])];
+}
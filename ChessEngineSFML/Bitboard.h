@@ -0,0 +1,185 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "ChessTypes.h"
+
+#include <bit>
+#include <cstdint>
+
+// --------------------------------------------------
+// Bitboards: one bit per square, bit index = row * 8 + col
+// (a1 = 0, h1 = 7, a8 = 56, h8 = 63)
+// --------------------------------------------------
+typedef uint64_t Bitboard;
+
+constexpr int squareOf(int row, int col) { return row * 8 + col; }
+constexpr int rowOf(int sq) { return sq >> 3; }
+constexpr int colOf(int sq) { return sq & 7; }
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+constexpr Bitboard RANK_1_BB = 0xFFULL;
+constexpr Bitboard RANK_3_BB = RANK_1_BB << 16;
+constexpr Bitboard RANK_6_BB = RANK_1_BB << 40;
+constexpr Bitboard RANK_8_BB = RANK_1_BB << 56;
+constexpr Bitboard DARK_SQUARES_BB = 0xAA55AA55AA55AA55ULL; // a1 is dark
+
+constexpr Bitboard squareBB(int sq) { return 1ULL << sq; }
+constexpr int popCount(Bitboard b) { return std::popcount(b); }
+constexpr int lsb(Bitboard b) { return std::countr_zero(b); }
+constexpr int msb(Bitboard b) { return 63 - std::countl_zero(b); }
+constexpr bool moreThanOne(Bitboard b) { return (b & (b - 1)) != 0; }
+constexpr Bitboard fileBB(int sq) { return FILE_A_BB << colOf(sq); }
+
+// Returns the lowest set square and clears it
+constexpr int popLsb(Bitboard& b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+// Ray directions. The first four move towards higher square indices.
+enum Direction {
+    NORTH = 0, EAST, NORTH_EAST, NORTH_WEST,
+    SOUTH, WEST, SOUTH_WEST, SOUTH_EAST,
+    DIRECTION_COUNT
+};
+
+// Moves every square of 'b' one step in direction D (nothing wraps around
+// from the a-file to the h-file or back)
+template <Direction D>
+constexpr Bitboard shift(Bitboard b) {
+    return D == NORTH ? b << 8
+        : D == SOUTH ? b >> 8
+        : D == EAST ? (b & ~FILE_H_BB) << 1
+        : D == WEST ? (b & ~FILE_A_BB) >> 1
+        : D == NORTH_EAST ? (b & ~FILE_H_BB) << 9
+        : D == NORTH_WEST ? (b & ~FILE_A_BB) << 7
+        : D == SOUTH_EAST ? (b & ~FILE_H_BB) >> 7
+        : (b & ~FILE_A_BB) >> 9;
+}
+
+// Fills: every square of 'b' smeared to the edge of the board along its file
+constexpr Bitboard northFill(Bitboard b) {
+    b |= b << 8;
+    b |= b << 16;
+    return b | (b << 32);
+}
+
+constexpr Bitboard southFill(Bitboard b) {
+    b |= b >> 8;
+    b |= b >> 16;
+    return b | (b >> 32);
+}
+
+constexpr Bitboard fileFill(Bitboard b) { return northFill(b) | southFill(b); }
+
+// The squares in front of the pawns of color C on their files, not
+// including their own squares
+template <Color C>
+constexpr Bitboard frontSpans(Bitboard pawns) {
+    return (C == WHITE) ? northFill(pawns << 8) : southFill(pawns >> 8);
+}
+
+// Precomputed attack and geometry tables. The constructors are constexpr and
+// each table is constant-initialized in Bitboard.cpp, so they are computed by
+// the compiler and sit in the read-only data of the executable: no work at
+// startup, and the pages are shared by every running copy. (Separate tables
+// keep each compile-time evaluation well inside the compilers' step limits.)
+struct alignas(64) LeaperAttacks {
+    Bitboard pawn[2][64];     // [color][square] squares a pawn attacks
+    Bitboard knight[64];
+    Bitboard king[64];
+
+    constexpr LeaperAttacks();
+};
+
+struct alignas(64) RayMasks {
+    Bitboard ray[DIRECTION_COUNT][64]; // empty-board ray, excluding the start square
+    Bitboard between[64][64]; // squares strictly between two aligned squares
+
+    constexpr RayMasks();
+};
+
+struct alignas(64) LineMasks {
+    Bitboard line[64][64];    // whole line through two aligned squares
+
+    constexpr LineMasks();
+};
+
+struct alignas(64) SquareDistances {
+    uint8_t distance[64][64]; // king steps from one square to another
+
+    constexpr SquareDistances();
+};
+
+extern const LeaperAttacks leaperAttacks;
+extern const RayMasks rayMasks;
+extern const LineMasks lineMasks;
+extern const SquareDistances squareDistances;
+
+inline Bitboard pawnAttacks(Color c, int sq) { return leaperAttacks.pawn[c][sq]; }
+
+// Squares attacked by all the pawns in 'pawns' at once
+template <Color C>
+constexpr Bitboard pawnAttacksBB(Bitboard pawns) {
+    return (C == WHITE)
+        ? shift<NORTH_WEST>(pawns) | shift<NORTH_EAST>(pawns)
+        : shift<SOUTH_WEST>(pawns) | shift<SOUTH_EAST>(pawns);
+}
+
+inline Bitboard pawnAttacksBB(Color c, Bitboard pawns) {
+    return (c == WHITE) ? pawnAttacksBB<WHITE>(pawns) : pawnAttacksBB<BLACK>(pawns);
+}
+
+inline Bitboard knightAttacks(int sq) { return leaperAttacks.knight[sq]; }
+inline Bitboard kingAttacks(int sq) { return leaperAttacks.king[sq]; }
+inline Bitboard betweenBB(int a, int b) { return rayMasks.between[a][b]; }
+inline Bitboard lineBB(int a, int b) { return lineMasks.line[a][b]; }
+inline int squareDistance(int a, int b) { return squareDistances.distance[a][b]; }
+
+// Attacks along one ray, stopping at (and including) the first blocker
+inline Bitboard rayAttacks(Direction dir, int sq, Bitboard occupied) {
+    Bitboard ray = rayMasks.ray[dir][sq];
+    Bitboard blockers = ray & occupied;
+    if (blockers) {
+        int blocker = (dir < SOUTH) ? lsb(blockers) : msb(blockers);
+        ray ^= rayMasks.ray[dir][blocker];
+    }
+    return ray;
+}
+
+inline Bitboard rayRookAttacks(int sq, Bitboard occupied) {
+    return rayAttacks(NORTH, sq, occupied) | rayAttacks(SOUTH, sq, occupied)
+        | rayAttacks(EAST, sq, occupied) | rayAttacks(WEST, sq, occupied);
+}
+
+inline Bitboard rayBishopAttacks(int sq, Bitboard occupied) {
+    return rayAttacks(NORTH_EAST, sq, occupied) | rayAttacks(NORTH_WEST, sq, occupied)
+        | rayAttacks(SOUTH_EAST, sq, occupied) | rayAttacks(SOUTH_WEST, sq, occupied);
+}
+
+// Slider attacks by table lookup, indexed by PEXT of the occupancy under the
+// piece's relevant squares. Only usable once initPextSliders() has run, on a
+// CPU with BMI2 (Cpu.cpp takes care of both).
+void initPextSliders();
+Bitboard pextRookAttacks(int sq, Bitboard occupied);
+Bitboard pextBishopAttacks(int sq, Bitboard occupied);
+
+// Which slider implementation rookAttacks/bishopAttacks use
+enum SliderPath { SLIDER_RAYS, SLIDER_PEXT };
+extern SliderPath sliderPath;
+
+inline Bitboard rookAttacks(int sq, Bitboard occupied) {
+    return (sliderPath == SLIDER_PEXT) ? pextRookAttacks(sq, occupied) : rayRookAttacks(sq, occupied);
+}
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupied) {
+    return (sliderPath == SLIDER_PEXT) ? pextBishopAttacks(sq, occupied) : rayBishopAttacks(sq, occupied);
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupied) {
+    return rookAttacks(sq, occupied) | bishopAttacks(sq, occupied);
+}
+
+#endif // BITBOARD_H
@@ -1,10 +1,156 @@
 #include "Board.h"
+#include "Psqt.h"
 
-#include <algorithm> // for std::max, std::min
+#include <algorithm> // for std::max, std::min, std::swap
+#include <cassert>
+#include <cctype>    // for std::isupper, std::tolower
+#include <cstdlib>   // for std::abs
+#include <random>
+#include <sstream>
+
+// --------------------------
+// Zobrist Keys
+// --------------------------
+struct ZobristKeys {
+    uint64_t piece[2][7][Board::SIZE * Board::SIZE];
+    uint64_t side;
+    uint64_t castling[16]; // one per combination of castling rights
+    uint64_t epFile[8];
+
+    ZobristKeys() {
+        // Fixed seed so keys (and TT behaviour) are reproducible between runs
+        std::mt19937_64 rng(0x9E3779B97F4A7C15ULL);
+        for (int c = 0; c < 2; c++) {
+            for (int t = 0; t < 7; t++) {
+                for (int sq = 0; sq < Board::SIZE * Board::SIZE; sq++) {
+                    piece[c][t][sq] = (t == EMPTY) ? 0 : rng();
+                }
+            }
+        }
+        side = rng();
+        for (auto& key : castling) {
+            key = rng();
+        }
+        castling[0] = 0;
+        for (auto& key : epFile) {
+            key = rng();
+        }
+    }
+};
+
+static const ZobristKeys zobrist;
+
+static inline uint64_t pieceKey(const Piece& p, int r, int c) {
+    if (p.type == EMPTY) return 0;
+    return zobrist.piece[p.color][p.type][r * Board::SIZE + c];
+}
+
+static inline uint64_t epKey(int epSquare) {
+    return (epSquare < 0) ? 0 : zobrist.epFile[colOf(epSquare)];
+}
+
+// The material key has one term per piece: the 'index'-th piece of a type
+// and color (counting from 0) adds the piece key of square 'index'. Any
+// set of piece counts gets its own key, whatever squares the pieces are on.
+static inline uint64_t materialKeyOf(Color c, PieceType t, int index) {
+    return zobrist.piece[c][t][index];
+}
+
+// Rights that survive a move touching each square: moving the king or a
+// rook from its corner (or capturing on that corner) clears the right
+struct CastlingMasks {
+    int mask[64];
+
+    CastlingMasks() {
+        for (int& m : mask) {
+            m = 0xF;
+        }
+        mask[squareOf(0, 4)] &= ~(Board::WHITE_OO | Board::WHITE_OOO);
+        mask[squareOf(0, 7)] &= ~Board::WHITE_OO;
+        mask[squareOf(0, 0)] &= ~Board::WHITE_OOO;
+        mask[squareOf(7, 4)] &= ~(Board::BLACK_OO | Board::BLACK_OOO);
+        mask[squareOf(7, 7)] &= ~Board::BLACK_OO;
+        mask[squareOf(7, 0)] &= ~Board::BLACK_OOO;
+    }
+};
+
+static const CastlingMasks castlingMasks;
+
+// --------------------------
+// Cuckoo Table of Reversible Moves
+// --------------------------
+// Every non-pawn move between two squares on an empty board, keyed by the
+// Zobrist difference it makes (piece out, piece in, side flip). Two hash
+// functions with cuckoo displacement keep each lookup at two probes.
+// See Marcel van Kervinck, "Cuckoo hashing for repetition detection".
+struct CuckooTable {
+    static const int SIZE = 8192;
+    uint64_t keys[SIZE];
+    Move moves[SIZE];
+
+    static int h1(uint64_t key) { return static_cast<int>(key & (SIZE - 1)); }
+    static int h2(uint64_t key) { return static_cast<int>((key >> 16) & (SIZE - 1)); }
+
+    static bool reaches(PieceType t, int dr, int dc) {
+        int ar = std::abs(dr);
+        int ac = std::abs(dc);
+        switch (t) {
+        case KNIGHT: return (ar == 1 && ac == 2) || (ar == 2 && ac == 1);
+        case BISHOP: return ar == ac;
+        case ROOK:   return ar == 0 || ac == 0;
+        case QUEEN:  return ar == ac || ar == 0 || ac == 0;
+        case KING:   return std::max(ar, ac) == 1;
+        default:     return false;
+        }
+    }
+
+    CuckooTable() : keys(), moves() {
+        const int squares = Board::SIZE * Board::SIZE;
+        for (int color = 0; color < 2; color++) {
+            for (int t = KNIGHT; t <= KING; t++) {
+                for (int s1 = 0; s1 < squares; s1++) {
+                    for (int s2 = s1 + 1; s2 < squares; s2++) {
+                        int r1 = s1 / Board::SIZE, c1 = s1 % Board::SIZE;
+                        int r2 = s2 / Board::SIZE, c2 = s2 % Board::SIZE;
+                        if (!reaches(static_cast<PieceType>(t), r2 - r1, c2 - c1)) continue;
+
+                        uint64_t key = zobrist.piece[color][t][s1]
+                            ^ zobrist.piece[color][t][s2] ^ zobrist.side;
+                        Move move(r1, c1, r2, c2);
+
+                        // Insert, kicking out residents to their other slot
+                        int i = h1(key);
+                        while (true) {
+                            std::swap(keys[i], key);
+                            std::swap(moves[i], move);
+                            if (key == 0) break; // empty slot reached
+                            i = (i == h1(key)) ? h2(key) : h1(key);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Returns the stored move for 'key', or a null move
+    Move lookup(uint64_t key) const {
+        int i = h1(key);
+        if (keys[i] == key) return moves[i];
+        i = h2(key);
+        if (keys[i] == key) return moves[i];
+        return Move();
+    }
+};
+
+static const CuckooTable cuckoo;
 
 Board::Board() {
     initBoard();
     sideToMove = WHITE;
+    halfmoveClock = 0;
+    castlingRights = WHITE_OO | WHITE_OOO | BLACK_OO | BLACK_OOO;
+    epSquare = -1;
+    hash = computeHash();
 }
 
 // Initialize standard chess board
@@ -47,166 +193,868 @@ void Board::initBoard() {
     // Kings
     board[0][4] = Piece(KING, WHITE);
     board[7][4] = Piece(KING, BLACK);
+
+    syncBitboards();
+}
+
+void Board::syncBitboards() {
+    cacheFlags = 0;
+    accumulators.clear();
+    for (int color = 0; color < 2; color++) {
+        colorBB[color] = 0;
+        for (int t = 0; t < 7; t++) {
+            pieceBB[color][t] = 0;
+            pieceCount[color][t] = 0;
+        }
+    }
+    for (int sq = 0; sq < 64; sq++) {
+        pieceIndex[sq] = -1;
+    }
+    for (int r = 0; r < SIZE; r++) {
+        for (int c = 0; c < SIZE; c++) {
+            const Piece& p = board[r][c];
+            if (p.type != EMPTY) {
+                int sq = squareOf(r, c);
+                pieceBB[p.color][p.type] |= squareBB(sq);
+                colorBB[p.color] |= squareBB(sq);
+                pieceIndex[sq] = pieceCount[p.color][p.type]++;
+                pieceList[p.color][p.type][pieceIndex[sq]] = sq;
+            }
+        }
+    }
+    psq = computePsq();
+    pawnKey = computePawnKey();
+    materialKey = computeMaterialKey();
+}
+
+Score Board::computePsq() const {
+    Score total = SCORE_ZERO;
+    for (int color = 0; color < 2; color++) {
+        for (int t = PAWN; t <= KING; t++) {
+            Bitboard b = pieceBB[color][t];
+            while (b) {
+                int sq = popLsb(b);
+                total += psqt.psq[color][t][sq];
+            }
+        }
+    }
+    return total;
 }
 
 bool Board::inBounds(int r, int c) const {
     return (r >= 0 && r < SIZE && c >= 0 && c < SIZE);
 }
 
-std::vector<Move> Board::generateMoves() {
-    std::vector<Move> moves;
+bool Board::loadFEN(const std::string& fen) {
+    std::istringstream in(fen);
+    std::string placement, side, castling, enPassant;
+    int halfmove = 0;
+    in >> placement >> side >> castling >> enPassant >> halfmove;
+    if (placement.empty() || (side != "w" && side != "b")) {
+        return false;
+    }
+
+    // Every rank must come to exactly eight files, and each side needs
+    // exactly one king (the search and the evaluation take its square)
+    Piece parsed[SIZE][SIZE];
+    int kings[2] = { 0, 0 };
+    int r = SIZE - 1;
+    int c = 0;
+    for (char ch : placement) {
+        if (ch == '/') {
+            if (c != SIZE) return false;
+            r--;
+            c = 0;
+        }
+        else if (ch >= '1' && ch <= '8') {
+            c += ch - '0';
+            if (c > SIZE) return false;
+        }
+        else {
+            PieceType type;
+            switch (std::tolower(static_cast<unsigned char>(ch))) {
+            case 'p': type = PAWN;   break;
+            case 'n': type = KNIGHT; break;
+            case 'b': type = BISHOP; break;
+            case 'r': type = ROOK;   break;
+            case 'q': type = QUEEN;  break;
+            case 'k': type = KING;   break;
+            default:  return false;
+            }
+            if (!inBounds(r, c)) return false;
+            Color color = std::isupper(static_cast<unsigned char>(ch)) ? WHITE : BLACK;
+            if (type == KING) kings[color]++;
+            parsed[r][c++] = Piece(type, color);
+        }
+    }
+    if (r != 0 || c != SIZE || kings[WHITE] != 1 || kings[BLACK] != 1) {
+        return false;
+    }
+
+    int rights = 0;
+    for (char ch : castling) {
+        switch (ch) {
+        case 'K': rights |= WHITE_OO;  break;
+        case 'Q': rights |= WHITE_OOO; break;
+        case 'k': rights |= BLACK_OO;  break;
+        case 'q': rights |= BLACK_OOO; break;
+        default:  break; // '-' or missing field
+        }
+    }
+
+    Color us = (side == "w") ? WHITE : BLACK;
+    int ep = -1;
+    if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h'
+        && enPassant[1] == (us == WHITE ? '6' : '3')) {
+        ep = squareOf(enPassant[1] - '1', enPassant[0] - 'a');
+    }
+
+    for (r = 0; r < SIZE; r++) {
+        for (c = 0; c < SIZE; c++) {
+            board[r][c] = parsed[r][c];
+        }
+    }
+    sideToMove = us;
+    halfmoveClock = halfmove;
+    castlingRights = rights;
+    epSquare = ep;
+    history.clear();
+    syncBitboards();
+    dropUnusableRights();
+    hash = computeHash();
+    return true;
+}
+
+void Board::setPosition(const Bitboard pieces[2][7], Color side, int castling, int ep, int halfmove) {
     for (int r = 0; r < SIZE; r++) {
         for (int c = 0; c < SIZE; c++) {
-            Piece piece = board[r][c];
-            if (piece.color == sideToMove) {
-                switch (piece.type) {
-                case PAWN:
-                    generatePawnMoves(r, c, moves);
-                    break;
-                case KNIGHT:
-                    generateKnightMoves(r, c, moves);
-                    break;
-                case BISHOP:
-                    generateSlidingMoves(r, c, moves, { {1,1},{1,-1},{-1,1},{-1,-1} });
-                    break;
-                case ROOK:
-                    generateSlidingMoves(r, c, moves, { {1,0},{-1,0},{0,1},{0,-1} });
-                    break;
-                case QUEEN:
-                    generateSlidingMoves(r, c, moves, {
-                        {1,0},{-1,0},{0,1},{0,-1},
-                        {1,1},{1,-1},{-1,1},{-1,-1}
-                        });
-                    break;
-                case KING:
-                    generateKingMoves(r, c, moves);
-                    break;
-                default:
-                    break;
-                }
+            board[r][c] = Piece(EMPTY, NO_COLOR);
+        }
+    }
+    for (int color = 0; color < 2; color++) {
+        for (int t = PAWN; t <= KING; t++) {
+            Bitboard b = pieces[color][t];
+            while (b) {
+                int sq = popLsb(b);
+                board[rowOf(sq)][colOf(sq)] = Piece(static_cast<PieceType>(t), static_cast<Color>(color));
             }
         }
     }
-    return moves;
+    sideToMove = side;
+    halfmoveClock = halfmove;
+    castlingRights = castling;
+    epSquare = ep;
+    history.clear();
+    syncBitboards();
+    dropUnusableRights();
+    hash = computeHash();
 }
 
-// Make a move on the board
-void Board::makeMove(const Move& m) {
-    Piece& src = board[m.fromRow][m.fromCol];
-    Piece& dst = board[m.toRow][m.toCol];
+// A castling right needs the king on its home square and the rook in its
+// corner; without them, castling would move a rook that is not there. An en
+// passant square needs the enemy pawn just in front of it, with the square
+// and the one the pawn came from empty, and is only kept when one of our
+// pawns can take on it, as makeMove records it, so the hash matches the same
+// position reached by moves.
+void Board::dropUnusableRights() {
+    struct CastlingSquares {
+        int right;
+        Color color;
+        int king;
+        int rook;
+    };
+    static const CastlingSquares castlingSquares[4] = {
+        { WHITE_OO,  WHITE, squareOf(0, 4), squareOf(0, 7) },
+        { WHITE_OOO, WHITE, squareOf(0, 4), squareOf(0, 0) },
+        { BLACK_OO,  BLACK, squareOf(7, 4), squareOf(7, 7) },
+        { BLACK_OOO, BLACK, squareOf(7, 4), squareOf(7, 0) },
+    };
+    for (const CastlingSquares& cs : castlingSquares) {
+        if (!(pieceBB[cs.color][KING] & squareBB(cs.king)) || !(pieceBB[cs.color][ROOK] & squareBB(cs.rook))) {
+            castlingRights &= ~cs.right;
+        }
+    }
 
-    // Move piece
-    dst = src;
-    src = Piece(EMPTY, NO_COLOR);
+    if (epSquare >= 0) {
+        Color us = sideToMove;
+        Color them = (us == WHITE) ? BLACK : WHITE;
+        int pushed = (us == WHITE) ? epSquare - 8 : epSquare + 8;
+        int start = (us == WHITE) ? epSquare + 8 : epSquare - 8;
+        Bitboard occupied = colorBB[WHITE] | colorBB[BLACK];
+        if (rowOf(epSquare) != ((us == WHITE) ? 5 : 2)
+            || !(pieceBB[them][PAWN] & squareBB(pushed))
+            || (occupied & (squareBB(epSquare) | squareBB(start)))
+            || !(pawnAttacks(them, epSquare) & pieceBB[us][PAWN])) {
+            epSquare = -1;
+        }
+    }
+}
 
-    // Pawn promotion (simplified: auto-queen)
-    if (dst.type == PAWN) {
-        if ((dst.color == WHITE && m.toRow == 7) ||
-            (dst.color == BLACK && m.toRow == 0)) {
-            dst.type = QUEEN;
+uint64_t Board::computeHash() const {
+    uint64_t key = 0;
+    for (int r = 0; r < SIZE; r++) {
+        for (int c = 0; c < SIZE; c++) {
+            key ^= pieceKey(board[r][c], r, c);
         }
     }
+    if (sideToMove == BLACK) {
+        key ^= zobrist.side;
+    }
+    key ^= zobrist.castling[castlingRights];
+    key ^= epKey(epSquare);
+    return key;
+}
 
-    // Switch side
-    sideToMove = (sideToMove == WHITE ? BLACK : WHITE);
+uint64_t Board::computeMaterialKey() const {
+    uint64_t key = 0;
+    for (int color = 0; color < 2; color++) {
+        for (int t = PAWN; t <= KING; t++) {
+            for (int i = 0; i < pieceCount[color][t]; i++) {
+                key ^= materialKeyOf(static_cast<Color>(color), static_cast<PieceType>(t), i);
+            }
+        }
+    }
+    return key;
 }
 
-// Undo move
-void Board::undoMove(const Move& m, Piece captured) {
-    Piece& src = board[m.fromRow][m.fromCol];
-    Piece& dst = board[m.toRow][m.toCol];
+uint64_t Board::computePawnKey() const {
+    uint64_t key = 0;
+    for (int color = 0; color < 2; color++) {
+        Bitboard b = pieceBB[color][PAWN];
+        while (b) {
+            key ^= zobrist.piece[color][PAWN][popLsb(b)];
+        }
+    }
+    return key;
+}
 
-    // Restore
-    src = dst;
-    dst = captured;
+// Adds one move per target square
+static void addMoves(int from, Bitboard targets, MoveList& moves) {
+    while (targets) {
+        int to = popLsb(targets);
+        moves.add(Move(rowOf(from), colOf(from), rowOf(to), colOf(to)));
+    }
+}
 
-    // Pawn promotion revert
-    if (src.type == QUEEN &&
-        ((m.toRow == 7 && src.color == WHITE) ||
-            (m.toRow == 0 && src.color == BLACK))) {
-        src.type = PAWN;
+// Adds one promotion per target: the queen and/or the three underpromotions,
+// depending on which generator asks
+static void addPromotions(int from, int to, bool queens, bool underpromotions, MoveList& moves) {
+    static const PieceType minorPromotions[3] = { KNIGHT, ROOK, BISHOP };
+    if (queens) {
+        moves.add(Move(rowOf(from), colOf(from), rowOf(to), colOf(to), QUEEN));
+    }
+    if (underpromotions) {
+        for (PieceType promo : minorPromotions) {
+            moves.add(Move(rowOf(from), colOf(from), rowOf(to), colOf(to), promo));
+        }
     }
+}
 
-    // Switch side back
-    sideToMove = (sideToMove == WHITE ? BLACK : WHITE);
+// Pawn moves of a whole set of pawns: each target's pawn stands 'offset'
+// squares behind it. Targets on the last rank become promotions.
+static void addPawnTargets(Bitboard targets, int offset, bool queens, bool underpromotions, MoveList& moves) {
+    while (targets) {
+        int to = popLsb(targets);
+        if (rowOf(to) == 0 || rowOf(to) == 7) {
+            addPromotions(to - offset, to, queens, underpromotions, moves);
+        }
+        else {
+            moves.add(Move(rowOf(to - offset), colOf(to - offset), rowOf(to), colOf(to)));
+        }
+    }
 }
 
-// --------------------------
-// Private Move Generators
-// --------------------------
-void Board::generatePawnMoves(int r, int c, std::vector<Move>& moves) {
-    Piece piece = board[r][c];
-    int dir = (piece.color == WHITE) ? 1 : -1;
-    int fr = r + dir;
+// Our pieces that are the only blocker between 'ksq' and a slider of color
+// 'sliders' aimed at it: pinned pieces if the king is ours, discovered-check
+// candidates if it is the enemy's
+static Bitboard sliderBlockers(const Board& b, int ksq, Color sliders, Color own) {
+    Bitboard occupied = b.colorBB[WHITE] | b.colorBB[BLACK];
+    Bitboard snipers =
+        (rookAttacks(ksq, 0) & (b.pieceBB[sliders][ROOK] | b.pieceBB[sliders][QUEEN]))
+        | (bishopAttacks(ksq, 0) & (b.pieceBB[sliders][BISHOP] | b.pieceBB[sliders][QUEEN]));
+    Bitboard result = 0;
+    while (snipers) {
+        Bitboard blockers = betweenBB(ksq, popLsb(snipers)) & occupied;
+        if (blockers && !moreThanOne(blockers) && (blockers & b.colorBB[own])) {
+            result |= blockers;
+        }
+    }
+    return result;
+}
 
-    // Move forward if empty
-    if (inBounds(fr, c) && board[fr][c].type == EMPTY) {
-        moves.push_back(Move(r, c, fr, c));
+void Board::generateMoves(GenType type, MoveList& moves) const {
+    if (sideToMove == WHITE) {
+        generateMovesFor<WHITE>(type, moves);
     }
-    // Capture diagonals
-    for (int dc = -1; dc <= 1; dc += 2) {
-        int fc = c + dc;
-        if (inBounds(fr, fc) && board[fr][fc].type != EMPTY
-            && board[fr][fc].color != piece.color) {
-            moves.push_back(Move(r, c, fr, fc));
-        }
+    else {
+        generateMovesFor<BLACK>(type, moves);
     }
 }
 
-void Board::generateKnightMoves(int r, int c, std::vector<Move>& moves) {
-    static const int offsets[8][2] = {
-        {2,1},{2,-1},{-2,1},{-2,-1},
-        {1,2},{1,-2},{-1,2},{-1,-2}
+template <Color Us>
+void Board::generateMovesFor(GenType type, MoveList& moves) const {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    constexpr Direction Up = (Us == WHITE) ? NORTH : SOUTH;
+    constexpr Direction UpWest = (Us == WHITE) ? NORTH_WEST : SOUTH_WEST;
+    constexpr Direction UpEast = (Us == WHITE) ? NORTH_EAST : SOUTH_EAST;
+    constexpr int UP = (Us == WHITE) ? 8 : -8; // the same steps as square offsets
+    constexpr Bitboard THIRD_RANK = (Us == WHITE) ? RANK_3_BB : RANK_6_BB;
+    constexpr Bitboard LAST_RANK = (Us == WHITE) ? RANK_8_BB : RANK_1_BB;
+    constexpr int BACK_ROW = (Us == WHITE) ? 0 : 7;
+    constexpr int KING_SIDE = (Us == WHITE) ? WHITE_OO : BLACK_OO;
+    constexpr int QUEEN_SIDE = (Us == WHITE) ? WHITE_OOO : BLACK_OOO;
+
+    Bitboard occupied = colorBB[WHITE] | colorBB[BLACK];
+    Bitboard own = colorBB[Us];
+    Bitboard enemies = colorBB[Them];
+    if (!pieceBB[Us][KING]) return;
+    int ksq = lsb(pieceBB[Us][KING]);
+
+    bool wantCaptures = (type != QUIETS && type != QUIET_CHECKS);
+    bool wantQuiets = (type != CAPTURES);
+
+    // Destination squares this generator is interested in
+    Bitboard typeMask = ~own;
+    if (type == CAPTURES) typeMask = enemies;
+    else if (type == QUIETS || type == QUIET_CHECKS) typeMask = ~occupied;
+
+    // Quiet checks: the squares from which each piece type attacks their
+    // king, and our pieces whose move off the line uncovers a slider
+    Bitboard checkSquares[7] = {};
+    Bitboard discoverers = 0;
+    int theirKsq = -1;
+    if (type == QUIET_CHECKS && pieceBB[Them][KING]) {
+        theirKsq = lsb(pieceBB[Them][KING]);
+        checkSquares[PAWN] = pawnAttacks(Them, theirKsq);
+        checkSquares[KNIGHT] = knightAttacks(theirKsq);
+        checkSquares[BISHOP] = bishopAttacks(theirKsq, occupied);
+        checkSquares[ROOK] = rookAttacks(theirKsq, occupied);
+        checkSquares[QUEEN] = checkSquares[BISHOP] | checkSquares[ROOK];
+        discoverers = sliderBlockers(*this, theirKsq, Us, Us);
+    }
+    auto checkMask = [&](int from, PieceType pt) -> Bitboard {
+        if (type != QUIET_CHECKS) return ~0ULL;
+        if (theirKsq < 0) return 0;
+        Bitboard mask = checkSquares[pt];
+        if (discoverers & squareBB(from)) mask |= ~lineBB(theirKsq, from);
+        return mask;
     };
-    Piece piece = board[r][c];
-    for (auto& off : offsets) {
-        int nr = r + off[0];
-        int nc = c + off[1];
-        if (inBounds(nr, nc)) {
-            if (board[nr][nc].color != piece.color) {
-                moves.push_back(Move(r, c, nr, nc));
-            }
+
+    // King moves: the king must not stay on a slider's line when it steps
+    // away, so test destinations with the king removed from the occupancy.
+    // (Probing the few candidate squares is cheaper here than building the
+    // full attackedBy() map, which most nodes would not otherwise need.)
+    Bitboard kingTargets = kingAttacks(ksq) & typeMask & checkMask(ksq, KING);
+    Bitboard withoutKing = occupied ^ squareBB(ksq);
+    Bitboard safeKingTargets = 0;
+    while (kingTargets) {
+        int to = popLsb(kingTargets);
+        if (!(attackersTo(to, withoutKing) & enemies)) {
+            safeKingTargets |= squareBB(to);
         }
     }
-}
+    addMoves(ksq, safeKingTargets, moves);
+
+    Bitboard checkersBB = checkers();
+
+    // In double check only the king can move
+    if (moreThanOne(checkersBB)) return;
+
+    // Single check: capture the checker or block between it and the king
+    Bitboard targetMask = ~own;
+    if (checkersBB) {
+        targetMask = checkersBB | betweenBB(ksq, lsb(checkersBB));
+    }
 
-void Board::generateSlidingMoves(int r, int c, std::vector<Move>& moves,
-    const std::vector<std::pair<int, int>>& directions)
-{
-    Piece piece = board[r][c];
-    for (auto& d : directions) {
-        int nr = r, nc = c;
-        while (true) {
-            nr += d.first;
-            nc += d.second;
-            if (!inBounds(nr, nc)) break;
-            if (board[nr][nc].type == EMPTY) {
-                moves.push_back(Move(r, c, nr, nc));
+    Bitboard pinned = sliderBlockers(*this, ksq, Them, Us);
+
+    // Pawns that are not pinned move as one set, by shifting the whole
+    // bitboard. Promotions are split by value: the queen counts as a capture,
+    // the underpromotions as quiet moves, whichever the pawn does to get there.
+    Bitboard pawns = pieceBB[Us][PAWN] & ~pinned;
+    Bitboard singlePushes = shift<Up>(pawns) & ~occupied;
+    Bitboard doublePushes = shift<Up>(singlePushes & THIRD_RANK) & ~occupied & targetMask;
+    Bitboard westCaptures = shift<UpWest>(pawns) & enemies & targetMask;
+    Bitboard eastCaptures = shift<UpEast>(pawns) & enemies & targetMask;
+    singlePushes &= targetMask;
+
+    if (type == QUIET_CHECKS) {
+        // Direct checks, or pushes of a pawn that uncovers a slider (any push
+        // does unless the pawn stands on the king's file)
+        Bitboard uncovering = (theirKsq >= 0) ? pawns & discoverers & ~fileBB(theirKsq) : 0;
+        singlePushes &= checkSquares[PAWN] | shift<Up>(uncovering);
+        doublePushes &= checkSquares[PAWN] | shift<Up>(shift<Up>(uncovering));
+        singlePushes &= ~LAST_RANK;
+    }
+    if (wantQuiets) {
+        addPawnTargets(singlePushes & ~LAST_RANK, UP, false, false, moves);
+        addPawnTargets(doublePushes, 2 * UP, false, false, moves);
+    }
+    if (wantCaptures) {
+        addPawnTargets(westCaptures & ~LAST_RANK, UP - 1, false, false, moves);
+        addPawnTargets(eastCaptures & ~LAST_RANK, UP + 1, false, false, moves);
+    }
+    if (type != QUIET_CHECKS) {
+        addPawnTargets(singlePushes & LAST_RANK, UP, wantCaptures, wantQuiets, moves);
+        addPawnTargets(westCaptures & LAST_RANK, UP - 1, wantCaptures, wantQuiets, moves);
+        addPawnTargets(eastCaptures & LAST_RANK, UP + 1, wantCaptures, wantQuiets, moves);
+    }
+
+    // Pinned pawns one by one: they may only move along the pin line
+    Bitboard pinnedPawns = pieceBB[Us][PAWN] & pinned;
+    while (pinnedPawns) {
+        int from = popLsb(pinnedPawns);
+        Bitboard captures = pawnAttacks(Us, from) & enemies;
+        Bitboard pushes = shift<Up>(squareBB(from)) & ~occupied;
+        pushes |= shift<Up>(pushes & THIRD_RANK) & ~occupied;
+
+        Bitboard targets = 0;
+        if (type == CAPTURES) targets = captures | (pushes & LAST_RANK);
+        else if (type == QUIETS) targets = pushes | (captures & LAST_RANK);
+        else if (type == QUIET_CHECKS) targets = pushes & ~LAST_RANK & checkMask(from, PAWN);
+        else targets = captures | pushes;
+
+        targets &= targetMask & lineBB(ksq, from);
+        while (targets) {
+            int to = popLsb(targets);
+            if (squareBB(to) & LAST_RANK) {
+                addPromotions(from, to, wantCaptures, wantQuiets && type != QUIET_CHECKS, moves);
             }
             else {
-                // Capture?
-                if (board[nr][nc].color != piece.color) {
-                    moves.push_back(Move(r, c, nr, nc));
-                }
-                break; // blocked
+                moves.add(Move(rowOf(from), colOf(from), rowOf(to), colOf(to)));
+            }
+        }
+    }
+
+    // En passant: rare enough to verify directly, by checking the king with
+    // both pawns gone from their squares and ours on the target square
+    if (epSquare >= 0 && wantCaptures) {
+        int capturedSq = epSquare - UP;
+        Bitboard candidates = pawnAttacks(Them, epSquare) & pieceBB[Us][PAWN];
+        while (candidates) {
+            int from = popLsb(candidates);
+            Bitboard after = (occupied ^ squareBB(from) ^ squareBB(capturedSq)) | squareBB(epSquare);
+            if (!(attackersTo(ksq, after) & enemies & ~squareBB(capturedSq))) {
+                moves.add(Move(rowOf(from), colOf(from), rowOf(epSquare), colOf(epSquare),
+                    EMPTY, EN_PASSANT));
             }
         }
     }
+
+    // Castling: rights left, the rook still in its corner, nothing in
+    // between, and the king neither in check nor passing through or landing
+    // on an attacked square
+    if (!checkersBB && (type == QUIETS || type == LEGAL)) {
+        if ((castlingRights & KING_SIDE) && (pieceBB[Us][ROOK] & squareBB(squareOf(BACK_ROW, 7)))
+            && !(occupied & betweenBB(squareOf(BACK_ROW, 4), squareOf(BACK_ROW, 7)))
+            && !(attackedBy(Them) & (squareBB(squareOf(BACK_ROW, 5)) | squareBB(squareOf(BACK_ROW, 6))))) {
+            moves.add(Move(BACK_ROW, 4, BACK_ROW, 6, EMPTY, CASTLING));
+        }
+        if ((castlingRights & QUEEN_SIDE) && (pieceBB[Us][ROOK] & squareBB(squareOf(BACK_ROW, 0)))
+            && !(occupied & betweenBB(squareOf(BACK_ROW, 4), squareOf(BACK_ROW, 0)))
+            && !(attackedBy(Them) & (squareBB(squareOf(BACK_ROW, 3)) | squareBB(squareOf(BACK_ROW, 2))))) {
+            moves.add(Move(BACK_ROW, 4, BACK_ROW, 2, EMPTY, CASTLING));
+        }
+    }
+
+    // Knights (a pinned knight can never move), bishops, rooks, queens
+    Bitboard knights = pieceBB[Us][KNIGHT] & ~pinned;
+    while (knights) {
+        int from = popLsb(knights);
+        addMoves(from, knightAttacks(from) & targetMask & typeMask & checkMask(from, KNIGHT), moves);
+    }
+    for (int t = BISHOP; t <= QUEEN; t++) {
+        Bitboard sliders = pieceBB[Us][t];
+        while (sliders) {
+            int from = popLsb(sliders);
+            Bitboard targets =
+                (t == BISHOP) ? bishopAttacks(from, occupied)
+                : (t == ROOK) ? rookAttacks(from, occupied)
+                : queenAttacks(from, occupied);
+            targets &= targetMask & typeMask & checkMask(from, static_cast<PieceType>(t));
+            if (pinned & squareBB(from)) targets &= lineBB(ksq, from);
+            addMoves(from, targets, moves);
+        }
+    }
 }
 
-void Board::generateKingMoves(int r, int c, std::vector<Move>& moves) {
-    Piece piece = board[r][c];
-    for (int dr = -1; dr <= 1; dr++) {
-        for (int dc = -1; dc <= 1; dc++) {
-            if (dr == 0 && dc == 0) continue;
-            int nr = r + dr;
-            int nc = c + dc;
-            if (inBounds(nr, nc)) {
-                if (board[nr][nc].color != piece.color) {
-                    moves.push_back(Move(r, c, nr, nc));
-                }
+std::vector<Move> Board::generateLegalMoves() const {
+    MoveList list;
+    generateMoves(LEGAL, list);
+    return std::vector<Move>(list.begin(), list.end());
+}
+
+// Reverse lookup: a square is attacked by a piece type exactly when that
+// piece type standing on the square would attack the attacker
+Bitboard Board::attackersTo(int sq, Bitboard occupied) const {
+    return (pawnAttacks(WHITE, sq) & pieceBB[BLACK][PAWN])
+        | (pawnAttacks(BLACK, sq) & pieceBB[WHITE][PAWN])
+        | (knightAttacks(sq) & (pieceBB[WHITE][KNIGHT] | pieceBB[BLACK][KNIGHT]))
+        | (kingAttacks(sq) & (pieceBB[WHITE][KING] | pieceBB[BLACK][KING]))
+        | (bishopAttacks(sq, occupied) & (pieceBB[WHITE][BISHOP] | pieceBB[BLACK][BISHOP]
+            | pieceBB[WHITE][QUEEN] | pieceBB[BLACK][QUEEN]))
+        | (rookAttacks(sq, occupied) & (pieceBB[WHITE][ROOK] | pieceBB[BLACK][ROOK]
+            | pieceBB[WHITE][QUEEN] | pieceBB[BLACK][QUEEN]));
+}
+
+Bitboard Board::attackedBy(Color side) const {
+    int flag = (side == WHITE) ? WHITE_ATTACKS_CACHED : BLACK_ATTACKS_CACHED;
+    if (cacheFlags & flag) {
+        return attackedCache[side];
+    }
+
+    Bitboard occupied = colorBB[WHITE] | colorBB[BLACK];
+    Bitboard attacks = pawnAttacksBB(side, pieceBB[side][PAWN]);
+    Bitboard pieces = pieceBB[side][KNIGHT];
+    while (pieces) {
+        attacks |= knightAttacks(popLsb(pieces));
+    }
+    pieces = pieceBB[side][BISHOP] | pieceBB[side][QUEEN];
+    while (pieces) {
+        attacks |= bishopAttacks(popLsb(pieces), occupied);
+    }
+    pieces = pieceBB[side][ROOK] | pieceBB[side][QUEEN];
+    while (pieces) {
+        attacks |= rookAttacks(popLsb(pieces), occupied);
+    }
+    if (pieceBB[side][KING]) {
+        attacks |= kingAttacks(lsb(pieceBB[side][KING]));
+    }
+
+    attackedCache[side] = attacks;
+    cacheFlags |= flag;
+    return attacks;
+}
+
+const Board::AttackMaps& Board::attackMaps() const {
+    if (cacheFlags & ATTACK_MAPS_CACHED) {
+        return attackMapsCache;
+    }
+
+    AttackMaps& maps = attackMapsCache;
+    Bitboard occupied = colorBB[WHITE] | colorBB[BLACK];
+    for (int color = 0; color < 2; color++) {
+        Color side = static_cast<Color>(color);
+
+        // Two pawns can hit one square; other pieces add to 'twice' as they go
+        Bitboard pawns = pieceBB[side][PAWN];
+        Bitboard left = (side == WHITE) ? shift<NORTH_WEST>(pawns) : shift<SOUTH_WEST>(pawns);
+        Bitboard right = (side == WHITE) ? shift<NORTH_EAST>(pawns) : shift<SOUTH_EAST>(pawns);
+        Bitboard all = left | right;
+        Bitboard twice = left & right;
+        maps.byType[side][PAWN] = all;
+        for (Bitboard x = pawns; x; ) {
+            int sq = popLsb(x);
+            maps.byPiece[sq] = pawnAttacks(side, sq);
+        }
+
+        for (int t = KNIGHT; t <= KING; t++) {
+            Bitboard typeAttacks = 0;
+            for (Bitboard x = pieceBB[side][t]; x; ) {
+                int sq = popLsb(x);
+                Bitboard attacks = (t == KNIGHT) ? knightAttacks(sq)
+                    : (t == BISHOP) ? bishopAttacks(sq, occupied)
+                    : (t == ROOK) ? rookAttacks(sq, occupied)
+                    : (t == QUEEN) ? queenAttacks(sq, occupied)
+                    : kingAttacks(sq);
+                maps.byPiece[sq] = attacks;
+                twice |= all & attacks;
+                all |= attacks;
+                typeAttacks |= attacks;
             }
+            maps.byType[side][t] = typeAttacks;
+        }
+        maps.byType[side][EMPTY] = all;
+        maps.twice[side] = twice;
+        attackedCache[side] = all;
+    }
+
+    cacheFlags |= ATTACK_MAPS_CACHED | WHITE_ATTACKS_CACHED | BLACK_ATTACKS_CACHED;
+    return maps;
+}
+
+Bitboard Board::checkers() const {
+    if (!(cacheFlags & CHECKERS_CACHED)) {
+        Bitboard king = pieceBB[sideToMove][KING];
+        Color them = (sideToMove == WHITE) ? BLACK : WHITE;
+        checkersCache = king
+            ? attackersTo(lsb(king), colorBB[WHITE] | colorBB[BLACK]) & colorBB[them]
+            : 0;
+        cacheFlags |= CHECKERS_CACHED;
+    }
+    return checkersCache;
+}
+
+// Is (r, c) attacked by any piece of color 'by'?
+bool Board::isSquareAttacked(int r, int c, Color by) const {
+    return (attackedBy(by) & squareBB(squareOf(r, c))) != 0;
+}
+
+bool Board::inCheck(Color side) const {
+    if (side == sideToMove) {
+        return checkers() != 0;
+    }
+    if (!pieceBB[side][KING]) return false;
+    int ksq = lsb(pieceBB[side][KING]);
+    return (attackersTo(ksq, colorBB[WHITE] | colorBB[BLACK]) & colorBB[sideToMove]) != 0;
+}
+
+bool Board::isDraw(int ply) const {
+    // Fifty-move rule (a mate delivered on the hundredth ply is not detected)
+    if (halfmoveClock >= 100) return true;
+
+    // Only positions since the last irreversible move can repeat, and only
+    // those with the same side to move: 4, 6, 8... plies back
+    int end = std::min(halfmoveClock, static_cast<int>(history.size()));
+    int occurrences = 0;
+    for (int i = 4; i <= end; i += 2) {
+        if (history[history.size() - i].key == hash) {
+            if (i < ply) return true; // repeated within the search tree
+            if (++occurrences == 2) return true; // threefold
         }
     }
+    return false;
+}
+
+bool Board::hasUpcomingRepetition(int ply) const {
+    int end = std::min(halfmoveClock, static_cast<int>(history.size()));
+    if (end < 3) return false;
+
+    // Compare with the positions 3, 5, 7... plies back: the side to move
+    // there is our opponent, so one move of ours could recreate them
+    for (int i = 3; i <= end; i += 2) {
+        uint64_t moveKey = hash ^ history[history.size() - i].key;
+        Move m = cuckoo.lookup(moveKey);
+        if (m.isNull()) continue;
+
+        // The move must not jump over anything
+        Bitboard path = betweenBB(squareOf(m.fromRow, m.fromCol), squareOf(m.toRow, m.toCol));
+        if (path & (colorBB[WHITE] | colorBB[BLACK])) continue;
+
+        // Positions at or before the root would need a threefold repetition,
+        // which isDraw() handles; only cycles inside the tree are taken here
+        if (ply > i) return true;
+    }
+    return false;
+}
+
+bool Board::isCapture(const Move& m) const {
+    return m.kind == EN_PASSANT || board[m.toRow][m.toCol].type != EMPTY;
 }
 
+void Board::putPiece(int sq, Piece p) {
+    board[rowOf(sq)][colOf(sq)] = p;
+    pieceBB[p.color][p.type] |= squareBB(sq);
+    colorBB[p.color] |= squareBB(sq);
+    pieceIndex[sq] = pieceCount[p.color][p.type]++;
+    pieceList[p.color][p.type][pieceIndex[sq]] = sq;
+    psq += psqt.psq[p.color][p.type][sq];
+}
+
+void Board::removePiece(int sq) {
+    Piece& p = board[rowOf(sq)][colOf(sq)];
+    pieceBB[p.color][p.type] ^= squareBB(sq);
+    colorBB[p.color] ^= squareBB(sq);
+
+    // The last piece of the list takes the freed slot
+    int* list = pieceList[p.color][p.type];
+    int last = list[--pieceCount[p.color][p.type]];
+    pieceIndex[last] = pieceIndex[sq];
+    list[pieceIndex[last]] = last;
+    pieceIndex[sq] = -1;
+
+    psq -= psqt.psq[p.color][p.type][sq];
+    p = Piece(EMPTY, NO_COLOR);
+}
+
+void Board::movePiece(int from, int to) {
+    Piece& src = board[rowOf(from)][colOf(from)];
+    Bitboard fromTo = squareBB(from) | squareBB(to);
+    pieceBB[src.color][src.type] ^= fromTo;
+    colorBB[src.color] ^= fromTo;
+    pieceIndex[to] = pieceIndex[from];
+    pieceList[src.color][src.type][pieceIndex[to]] = to;
+    pieceIndex[from] = -1;
+    psq += psqt.psq[src.color][src.type][to] - psqt.psq[src.color][src.type][from];
+    board[rowOf(to)][colOf(to)] = src;
+    src = Piece(EMPTY, NO_COLOR);
+}
+
+// Make a move on the board
+void Board::makeMove(const Move& m) {
+    if (sideToMove == WHITE) {
+        makeMoveFor<WHITE>(m);
+    }
+    else {
+        makeMoveFor<BLACK>(m);
+    }
+}
+
+template <Color Us>
+void Board::makeMoveFor(const Move& m) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    constexpr int UP = (Us == WHITE) ? 8 : -8;
+
+    int from = squareOf(m.fromRow, m.fromCol);
+    int to = squareOf(m.toRow, m.toCol);
+    Piece moving = board[m.fromRow][m.fromCol];
+
+    // The captured pawn of an en-passant capture is beside the target square
+    int capturedSq = (m.kind == EN_PASSANT) ? to - UP : to;
+    Piece captured = board[rowOf(capturedSq)][colOf(capturedSq)];
+
+    history.push_back({ hash, pawnKey, materialKey, halfmoveClock, castlingRights, epSquare, captured, {} });
+    cacheFlags = 0;
+
+    // Pieces the move changes, in the order NNUE needs: the moving piece
+    // first (so a king move is easy to spot), then a capture, then a
+    // promoted piece or the castling rook
+    DirtyPieces& dirty = history.back().dirty;
+    dirty.count = 1;
+    dirty.piece[0] = moving;
+    dirty.from[0] = static_cast<int8_t>(from);
+    dirty.to[0] = static_cast<int8_t>((m.promotion != EMPTY) ? -1 : to);
+    if (captured.type != EMPTY) {
+        dirty.piece[dirty.count] = captured;
+        dirty.from[dirty.count] = static_cast<int8_t>(capturedSq);
+        dirty.to[dirty.count++] = -1;
+    }
+    if (m.promotion != EMPTY) {
+        dirty.piece[dirty.count] = Piece(m.promotion, Us);
+        dirty.from[dirty.count] = -1;
+        dirty.to[dirty.count++] = static_cast<int8_t>(to);
+    }
+    if (history.size() < accumulators.size()) {
+        accumulators[history.size()].computedFor[WHITE] = 0;
+        accumulators[history.size()].computedFor[BLACK] = 0;
+    }
+
+    hash ^= epKey(epSquare);
+    epSquare = -1;
+
+    if (captured.type != EMPTY) {
+        hash ^= pieceKey(captured, rowOf(capturedSq), colOf(capturedSq));
+        if (captured.type == PAWN) {
+            pawnKey ^= zobrist.piece[Them][PAWN][capturedSq];
+        }
+        materialKey ^= materialKeyOf(Them, captured.type, pieceCount[Them][captured.type] - 1);
+        removePiece(capturedSq);
+    }
+
+    hash ^= pieceKey(moving, m.fromRow, m.fromCol);
+    if (moving.type == PAWN) {
+        pawnKey ^= zobrist.piece[Us][PAWN][from];
+        if (m.promotion == EMPTY) {
+            pawnKey ^= zobrist.piece[Us][PAWN][to];
+        }
+    }
+    movePiece(from, to);
+
+    // Pawn promotion
+    if (m.promotion != EMPTY) {
+        materialKey ^= materialKeyOf(Us, PAWN, pieceCount[Us][PAWN] - 1)
+            ^ materialKeyOf(Us, m.promotion, pieceCount[Us][m.promotion]);
+        removePiece(to);
+        putPiece(to, Piece(m.promotion, Us));
+    }
+    hash ^= pieceKey(board[m.toRow][m.toCol], m.toRow, m.toCol);
+
+    // Castling also moves the rook from its corner to the king's other side
+    if (m.kind == CASTLING) {
+        bool kingSide = (m.toCol == 6);
+        int rookFrom = squareOf(m.toRow, kingSide ? 7 : 0);
+        int rookTo = squareOf(m.toRow, kingSide ? 5 : 3);
+        Piece rook = board[rowOf(rookFrom)][colOf(rookFrom)];
+        dirty.piece[dirty.count] = rook;
+        dirty.from[dirty.count] = static_cast<int8_t>(rookFrom);
+        dirty.to[dirty.count++] = static_cast<int8_t>(rookTo);
+        hash ^= pieceKey(rook, rowOf(rookFrom), colOf(rookFrom));
+        hash ^= pieceKey(rook, rowOf(rookTo), colOf(rookTo));
+        movePiece(rookFrom, rookTo);
+    }
+
+    hash ^= zobrist.castling[castlingRights];
+    castlingRights &= castlingMasks.mask[from] & castlingMasks.mask[to];
+    hash ^= zobrist.castling[castlingRights];
+
+    // Only record an en-passant square when an enemy pawn could use it
+    if (moving.type == PAWN && to - from == 2 * UP) {
+        int passed = from + UP;
+        if (pawnAttacks(Us, passed) & pieceBB[Them][PAWN]) {
+            epSquare = passed;
+            hash ^= epKey(epSquare);
+        }
+    }
+
+    halfmoveClock = (moving.type == PAWN || captured.type != EMPTY) ? 0 : halfmoveClock + 1;
+
+    // Switch side
+    sideToMove = Them;
+    hash ^= zobrist.side;
+
+    assert(psq == computePsq());
+    assert(pawnKey == computePawnKey());
+    assert(materialKey == computeMaterialKey());
+}
+
+// Undo move
+void Board::undoMove(const Move& m) {
+    // The side that made the move is the one not to move now
+    if (sideToMove == WHITE) {
+        undoMoveFor<BLACK>(m);
+    }
+    else {
+        undoMoveFor<WHITE>(m);
+    }
+}
+
+template <Color Us>
+void Board::undoMoveFor(const Move& m) {
+    constexpr int UP = (Us == WHITE) ? 8 : -8;
+
+    const StateInfo& st = history.back();
+    int from = squareOf(m.fromRow, m.fromCol);
+    int to = squareOf(m.toRow, m.toCol);
+
+    // Switch side back
+    sideToMove = Us;
+
+    if (m.kind == CASTLING) {
+        bool kingSide = (m.toCol == 6);
+        movePiece(squareOf(m.toRow, kingSide ? 5 : 3), squareOf(m.toRow, kingSide ? 7 : 0));
+    }
+
+    // Pawn promotion revert
+    if (m.promotion != EMPTY) {
+        removePiece(to);
+        putPiece(to, Piece(PAWN, Us));
+    }
+
+    // Restore
+    movePiece(to, from);
+    if (st.captured.type != EMPTY) {
+        int capturedSq = (m.kind == EN_PASSANT) ? to - UP : to;
+        putPiece(capturedSq, st.captured);
+    }
+
+    // Everything else comes straight back from the history stack
+    hash = st.key;
+    pawnKey = st.pawnKey;
+    materialKey = st.materialKey;
+    halfmoveClock = st.halfmoveClock;
+    castlingRights = st.castlingRights;
+    epSquare = st.epSquare;
+    history.pop_back();
+    cacheFlags = 0;
+
+    assert(psq == computePsq());
+}
+
+std::string moveToString(const Move& m) {
+    std::string s;
+    s += static_cast<char>('a' + m.fromCol);
+    s += static_cast<char>('1' + m.fromRow);
+    s += static_cast<char>('a' + m.toCol);
+    s += static_cast<char>('1' + m.toRow);
+    return s;
+}
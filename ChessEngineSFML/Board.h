@@ -1,32 +1,185 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include "Bitboard.h"
 #include "ChessTypes.h"
+#include "Nnue.h"
+#include "Score.h"
+
+#include <cstdint>
+#include <string>
+
+// What Board::generateMoves produces. Every generator returns strictly legal
+// moves; CAPTURES and QUIETS together are all the moves of a position that is
+// not in check, EVASIONS is meant for positions that are.
+enum GenType {
+    CAPTURES,     // captures (en passant included) and queen promotions
+    QUIETS,       // non-captures, castling and underpromotions
+    EVASIONS,     // king moves, captures of the checker and blocks
+    QUIET_CHECKS, // non-captures that give check (castling and promotions excepted)
+    LEGAL         // everything
+};
 
 class Board {
 public:
     static const int SIZE = 8;
     Piece board[SIZE][SIZE];
     Color sideToMove; // 0 = WHITE, 1 = BLACK
+    uint64_t hash;    // Zobrist key, kept up to date by makeMove/undoMove
+    uint64_t pawnKey; // Zobrist key of the pawns alone (the pawn hash table's key)
+    uint64_t materialKey; // Zobrist key of the piece counts (the material table's key)
+    int halfmoveClock; // Plies since the last capture or pawn move (fifty-move rule)
+    int castlingRights; // CastlingRight flags still available
+    int epSquare;       // Square behind a pawn that just moved two squares, or -1
+
+    enum CastlingRight {
+        WHITE_OO = 1, WHITE_OOO = 2,
+        BLACK_OO = 4, BLACK_OOO = 8
+    };
+
+    // Bitboards, kept in sync with 'board' by every function that changes it
+    Bitboard pieceBB[2][7]; // [color][piece type]
+    Bitboard colorBB[2];    // all pieces of one color
+
+    // Piece lists: the squares of each color's pieces of each type, for code
+    // that prefers square lists to bitboards. Updated in O(1) alongside the
+    // bitboards; a removed piece's slot is filled with the last one in its list.
+    static const int MAX_PIECES_PER_TYPE = 10; // two plus eight promotions
+    int pieceList[2][7][MAX_PIECES_PER_TYPE];  // [color][piece type][index]
+    int pieceCount[2][7];
+    int pieceIndex[64]; // where the piece on a square sits in its list
+
+    // Sum of the piece-square table entries of every piece (Psqt.h), White
+    // minus Black. Updated alongside the bitboards, so evaluation reads it
+    // instead of visiting the pieces.
+    Score psq;
+
+    // One entry per move made on this board (game moves and search moves alike):
+    // everything undoMove cannot recompute about the position the move was made from
+    struct StateInfo {
+        uint64_t key;
+        uint64_t pawnKey;
+        uint64_t materialKey;
+        int halfmoveClock;
+        int castlingRights;
+        int epSquare;
+        Piece captured;
+        DirtyPieces dirty; // what the move changed, for the NNUE accumulators
+    };
+    std::vector<StateInfo> history;
+
+    // NNUE accumulators, one per entry of 'history' plus the current
+    // position. Filled by nnueEvaluate only when it is used; makeMove just
+    // marks the new position's entry as not computed.
+    mutable std::vector<NnueAccumulator> accumulators;
 
     Board();
     void initBoard();
     bool inBounds(int r, int c) const;
 
-    // Generate pseudo-legal moves (simplified)
-    std::vector<Move> generateMoves();
+    // Set up a position from FEN. Returns false on bad input.
+    bool loadFEN(const std::string& fen);
+
+    // Set up a position from piece bitboards ([color][piece type], the EMPTY
+    // entries are ignored) and the state FEN would give. Nothing is validated.
+    void setPosition(const Bitboard pieces[2][7], Color side, int castling, int ep, int halfmove);
+
+    // Full Zobrist recomputation (used on setup and for debugging)
+    uint64_t computeHash() const;
+    uint64_t computePawnKey() const;
+    uint64_t computeMaterialKey() const;
+
+    // Full recomputation of psq (used on setup and, in debug builds, to check
+    // the incremental value after every makeMove/undoMove)
+    Score computePsq() const;
+
+    // Appends the moves of kind 'type' to 'moves'. Checkers and pinned pieces
+    // are computed once from bitboard rays; pinned pieces stay on their pin
+    // line, only evasions are generated in check, and king moves are tested
+    // against the enemy attacks.
+    void generateMoves(GenType type, MoveList& moves) const;
 
-    // Execute / Undo moves
+    // All legal moves, including castling, en passant and underpromotions
+    std::vector<Move> generateLegalMoves() const;
+
+    // Attack queries
+    // Pieces of both colors attacking 'sq' given the occupancy 'occupied'
+    // (pass a modified occupancy to see through pieces, e.g. for x-rays)
+    Bitboard attackersTo(int sq, Bitboard occupied) const;
+
+    // Every square attacked by 'side' (occupied or not), and the enemy
+    // pieces giving check to the side to move. Both are computed on first
+    // use in a position and cached until the next move, so the generator,
+    // the search's check tests and evaluation can ask as often as they like.
+    Bitboard attackedBy(Color side) const;
+    Bitboard checkers() const;
+
+    // The attacks of every piece, by square and summed by color and type,
+    // built in one pass over the pieces on first use in a position and
+    // cached until the next move like attackedBy (which they also answer).
+    // Evaluation computes mobility, king safety and threats from them, and
+    // move ordering at the same node reuses them instead of recomputing.
+    struct AttackMaps {
+        Bitboard byPiece[64];  // what the piece on each square attacks (occupied squares only)
+        Bitboard byType[2][7]; // [color][piece type]; [color][EMPTY] is all of them
+        Bitboard twice[2];     // squares a color attacks at least twice
+    };
+    const AttackMaps& attackMaps() const;
+
+    bool isSquareAttacked(int r, int c, Color by) const;
+    bool inCheck(Color side) const;
+
+    // Draw by the fifty-move rule or by repetition. 'ply' is the distance from
+    // the search root: a repetition inside the search tree counts as a draw
+    // straight away, one of a game position needs a third occurrence.
+    bool isDraw(int ply) const;
+
+    // Can the side to move reach an earlier position with one reversible move
+    // (i.e. force a repetition)? Uses the cuckoo table of reversible moves.
+    bool hasUpcomingRepetition(int ply) const;
+
+    // Does 'm' take a piece (including en passant)?
+    bool isCapture(const Move& m) const;
+
+    // Execute / Undo moves. undoMove must get the last move made; everything
+    // else it needs comes from the history stack.
     void makeMove(const Move& m);
-    void undoMove(const Move& m, Piece captured);
+    void undoMove(const Move& m);
 
 private:
-    // Internal helpers for move generation
-    void generatePawnMoves(int r, int c, std::vector<Move>& moves);
-    void generateKnightMoves(int r, int c, std::vector<Move>& moves);
-    void generateSlidingMoves(int r, int c, std::vector<Move>& moves,
-        const std::vector<std::pair<int, int>>& directions);
-    void generateKingMoves(int r, int c, std::vector<Move>& moves);
+    // Rebuild the bitboards from 'board' (after setting up a position)
+    void syncBitboards();
+
+    // Drop whatever the setup fields grant that the pieces do not allow,
+    // and that makeMove would therefore never have left standing
+    void dropUnusableRights();
+
+    // Lazily filled attack caches; cacheFlags says which entries are valid
+    enum AttackCacheFlag {
+        WHITE_ATTACKS_CACHED = 1,
+        BLACK_ATTACKS_CACHED = 2,
+        CHECKERS_CACHED = 4,
+        ATTACK_MAPS_CACHED = 8
+    };
+    mutable Bitboard attackedCache[2];
+    mutable AttackMaps attackMapsCache;
+    mutable Bitboard checkersCache;
+    mutable int cacheFlags;
+
+    // Color-specialized bodies of generateMoves, makeMove and undoMove. The
+    // public functions dispatch on the side to move once, so pawn directions,
+    // promotion ranks and castling squares are compile-time constants inside.
+    template <Color Us> void generateMovesFor(GenType type, MoveList& moves) const;
+    template <Color Us> void makeMoveFor(const Move& m);
+    template <Color Us> void undoMoveFor(const Move& m);
+
+    // Board + bitboard updates shared by makeMove and undoMove (no hashing)
+    void putPiece(int sq, Piece p);
+    void removePiece(int sq);
+    void movePiece(int from, int to);
 };
 
+// Coordinate notation, e.g. "e2e4"
+std::string moveToString(const Move& m);
+
 #endif // BOARD_H
@@ -0,0 +1,302 @@
+#include "BoardBatch.h"
+#include "Cpu.h"
+#include "Evaluation.h"
+#include "Psqt.h"
+
+#include <iostream>
+#include <random>
+
+#if CPU_X86_64
+#include <immintrin.h>
+#endif
+
+void BoardBatch::reserve(size_t count) {
+    for (int color = 0; color < 2; color++) {
+        for (int t = PAWN; t <= KING; t++) {
+            pieceBB[color][t].reserve(count);
+        }
+    }
+    sideToMove.reserve(count);
+    castlingRights.reserve(count);
+    epSquare.reserve(count);
+    halfmoveClock.reserve(count);
+}
+
+void BoardBatch::clear() {
+    for (int color = 0; color < 2; color++) {
+        for (int t = PAWN; t <= KING; t++) {
+            pieceBB[color][t].clear();
+        }
+    }
+    sideToMove.clear();
+    castlingRights.clear();
+    epSquare.clear();
+    halfmoveClock.clear();
+}
+
+void BoardBatch::add(const Board& b) {
+    for (int color = 0; color < 2; color++) {
+        for (int t = PAWN; t <= KING; t++) {
+            pieceBB[color][t].push_back(b.pieceBB[color][t]);
+        }
+    }
+    sideToMove.push_back(static_cast<uint8_t>(b.sideToMove));
+    castlingRights.push_back(static_cast<uint8_t>(b.castlingRights));
+    epSquare.push_back(static_cast<int8_t>(b.epSquare));
+    halfmoveClock.push_back(static_cast<uint16_t>(b.halfmoveClock));
+}
+
+void BoardBatch::add(const Bitboard pieces[2][7], Color side) {
+    for (int color = 0; color < 2; color++) {
+        for (int t = PAWN; t <= KING; t++) {
+            pieceBB[color][t].push_back(pieces[color][t]);
+        }
+    }
+    sideToMove.push_back(static_cast<uint8_t>(side));
+    castlingRights.push_back(0);
+    epSquare.push_back(-1);
+    halfmoveClock.push_back(0);
+}
+
+bool BoardBatch::addFEN(const std::string& fen) {
+    Board b;
+    if (!b.loadFEN(fen)) {
+        return false;
+    }
+    add(b);
+    return true;
+}
+
+void BoardBatch::loadInto(size_t index, Board& b) const {
+    Bitboard pieces[2][7] = {};
+    for (int color = 0; color < 2; color++) {
+        for (int t = PAWN; t <= KING; t++) {
+            pieces[color][t] = pieceBB[color][t][index];
+        }
+    }
+    b.setPosition(pieces, side(index), castlingRights[index], epSquare[index], halfmoveClock[index]);
+}
+
+std::string BoardBatch::toFEN(size_t index) const {
+    static const char PIECE_CHARS[2][8] = { " PNBRQK", " pnbrqk" };
+
+    std::string fen;
+    for (int r = 7; r >= 0; r--) {
+        int emptyRun = 0;
+        for (int c = 0; c < 8; c++) {
+            Bitboard bb = squareBB(squareOf(r, c));
+            char ch = 0;
+            for (int color = 0; color < 2 && !ch; color++) {
+                for (int t = PAWN; t <= KING; t++) {
+                    if (pieceBB[color][t][index] & bb) {
+                        ch = PIECE_CHARS[color][t];
+                        break;
+                    }
+                }
+            }
+            if (!ch) {
+                emptyRun++;
+                continue;
+            }
+            if (emptyRun) {
+                fen += static_cast<char>('0' + emptyRun);
+                emptyRun = 0;
+            }
+            fen += ch;
+        }
+        if (emptyRun) {
+            fen += static_cast<char>('0' + emptyRun);
+        }
+        if (r > 0) {
+            fen += '/';
+        }
+    }
+
+    fen += (sideToMove[index] == WHITE) ? " w " : " b ";
+
+    int rights = castlingRights[index];
+    if (rights & Board::WHITE_OO)  fen += 'K';
+    if (rights & Board::WHITE_OOO) fen += 'Q';
+    if (rights & Board::BLACK_OO)  fen += 'k';
+    if (rights & Board::BLACK_OOO) fen += 'q';
+    if (!rights) fen += '-';
+
+    int ep = epSquare[index];
+    if (ep >= 0) {
+        fen += ' ';
+        fen += static_cast<char>('a' + colOf(ep));
+        fen += static_cast<char>('1' + rowOf(ep));
+    }
+    else {
+        fen += " -";
+    }
+
+    fen += " " + std::to_string(halfmoveClock[index]) + " 1";
+    return fen;
+}
+
+Bitboard BoardBatch::occupied(size_t index) const {
+    Bitboard occ = 0;
+    for (int color = 0; color < 2; color++) {
+        for (int t = PAWN; t <= KING; t++) {
+            occ |= pieceBB[color][t][index];
+        }
+    }
+    return occ;
+}
+
+// --------------------------------------------------
+// Batch operations
+// --------------------------------------------------
+
+// score[i] += (white count - black count) * value over one piece type's arrays
+// (one multiply-add covers both halves of the packed value). A portable build
+// without -mpopcnt counts bits with shifts and masks, several times slower
+// than the POPCNT instruction this loop is made of, so there is a second
+// copy on the intrinsic, picked when the CPU has it.
+typedef void (*AddMaterialKernel)(const Bitboard* white, const Bitboard* black, Score value, Score* score, size_t n);
+
+static void addMaterialPortable(const Bitboard* white, const Bitboard* black, Score value, Score* score, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        score[i] += (popCount(white[i]) - popCount(black[i])) * value;
+    }
+}
+
+#if CPU_X86_64
+TARGET_POPCNT static void addMaterialPopcnt(const Bitboard* white, const Bitboard* black, Score value, Score* score, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int count = static_cast<int>(_mm_popcnt_u64(white[i])) - static_cast<int>(_mm_popcnt_u64(black[i]));
+        score[i] += count * value;
+    }
+}
+#endif
+
+static AddMaterialKernel addMaterial = addMaterialPortable;
+
+void selectBatchKernels(bool useExtensions) {
+    addMaterial = addMaterialPortable;
+#if CPU_X86_64
+    if (useExtensions && cpuFeatures().popcnt) {
+        addMaterial = addMaterialPopcnt;
+    }
+#endif
+}
+
+bool batchKernelSelfTest() {
+#if CPU_X86_64
+    if (!cpuFeatures().popcnt) {
+        std::cout << "POPCNT material : skipped (no POPCNT)\n";
+        return true;
+    }
+
+    // Sparse to dense boards, both signs of the difference
+    std::mt19937_64 rng(11);
+    const size_t n = 4096;
+    std::vector<Bitboard> white(n), black(n);
+    for (size_t i = 0; i < n; i++) {
+        white[i] = rng();
+        black[i] = rng();
+        if (i % 3 == 0) white[i] &= rng() & rng();
+        else if (i % 3 == 1) black[i] &= rng();
+    }
+    Score value = S(-37, 291);
+    std::vector<Score> expected(n, SCORE_ZERO), actual(n, SCORE_ZERO);
+    addMaterialPortable(white.data(), black.data(), value, expected.data(), n);
+    addMaterialPopcnt(white.data(), black.data(), value, actual.data(), n);
+    bool ok = expected == actual;
+    std::cout << "POPCNT material : " << (ok ? "ok" : "FAILED") << "\n";
+    return ok;
+#else
+    return true;
+#endif
+}
+
+void BoardBatch::materialScores(const EvalParameters& evalParams, std::vector<Score>& out) const {
+    size_t n = size();
+    out.assign(n, SCORE_ZERO);
+
+    // One pass per piece type over two contiguous arrays
+    for (int t = PAWN; t <= QUEEN; t++) {
+        Score value = pieceScore(static_cast<PieceType>(t), evalParams);
+        const Bitboard* white = pieceBB[WHITE][t].data();
+        const Bitboard* black = pieceBB[BLACK][t].data();
+        addMaterial(white, black, value, out.data(), n);
+    }
+}
+
+void BoardBatch::evalScores(const EvalParameters& evalParams, std::vector<int>& out) const {
+    std::vector<Score> material;
+    materialScores(evalParams, material);
+
+    // The piece-square sums are not stored, so each position's pieces are
+    // visited once here
+    size_t n = size();
+    out.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        Score score = material[i];
+        int phase = 0;
+        for (int color = 0; color < 2; color++) {
+            for (int t = PAWN; t <= KING; t++) {
+                Bitboard b = pieceBB[color][t][i];
+                phase += popCount(b) * PHASE_WEIGHTS[t];
+                while (b) {
+                    int sq = popLsb(b);
+                    score += psqt.psq[color][t][sq];
+                }
+            }
+        }
+        out[i] = taper(score, phase);
+    }
+}
+
+void BoardBatch::attackMaps(Color side, std::vector<Bitboard>& out) const {
+    size_t n = size();
+    out.resize(n);
+    Bitboard* attacks = out.data();
+
+    // Pawns and kings need no occupancy: whole-array passes
+    const Bitboard* pawns = pieceBB[side][PAWN].data();
+    const Bitboard* kings = pieceBB[side][KING].data();
+    for (size_t i = 0; i < n; i++) {
+        attacks[i] = pawnAttacksBB(side, pawns[i]);
+    }
+    for (size_t i = 0; i < n; i++) {
+        attacks[i] |= kings[i] ? kingAttacks(lsb(kings[i])) : 0;
+    }
+
+    const Bitboard* knights = pieceBB[side][KNIGHT].data();
+    for (size_t i = 0; i < n; i++) {
+        for (Bitboard b = knights[i]; b; ) {
+            attacks[i] |= knightAttacks(popLsb(b));
+        }
+    }
+
+    // Sliders, with each position's occupancy
+    const Bitboard* queens = pieceBB[side][QUEEN].data();
+    const Bitboard* rooks = pieceBB[side][ROOK].data();
+    const Bitboard* bishops = pieceBB[side][BISHOP].data();
+    for (size_t i = 0; i < n; i++) {
+        Bitboard occ = occupied(i);
+        for (Bitboard b = rooks[i] | queens[i]; b; ) {
+            attacks[i] |= rookAttacks(popLsb(b), occ);
+        }
+        for (Bitboard b = bishops[i] | queens[i]; b; ) {
+            attacks[i] |= bishopAttacks(popLsb(b), occ);
+        }
+    }
+}
+
+void BoardBatch::legalMoveCounts(std::vector<int>& out) const {
+    size_t n = size();
+    out.resize(n);
+
+    // Move generation works on a Board; one scratch board is reused for
+    // the whole batch
+    Board b;
+    for (size_t i = 0; i < n; i++) {
+        loadInto(i, b);
+        MoveList moves;
+        b.generateMoves(LEGAL, moves);
+        out[i] = static_cast<int>(moves.size());
+    }
+}
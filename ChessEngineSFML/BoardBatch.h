@@ -0,0 +1,76 @@
+#ifndef BOARDBATCH_H
+#define BOARDBATCH_H
+
+#include "Board.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct EvalParameters;
+
+// --------------------------------------------------
+// Many positions stored as structure-of-arrays
+// --------------------------------------------------
+// A Board is over a kilobyte (mailbox, bitboards, piece lists, history), so
+// a std::vector<Board> of training or analysis positions touches far more
+// memory than the positions themselves. A batch keeps only the twelve piece
+// bitboards and the FEN state of each position, one array per field, and its
+// batch operations sweep those arrays column by column: a material count for
+// all positions reads one pawn array, then one knight array, and so on, in
+// loops the compiler can vectorize.
+class BoardBatch {
+public:
+    size_t size() const { return sideToMove.size(); }
+    bool empty() const { return sideToMove.empty(); }
+    void reserve(size_t count);
+    void clear();
+
+    // Append a position
+    void add(const Board& b);
+    // Append a position given by its piece bitboards, without castling or
+    // en passant rights (training records, which keep nothing else)
+    void add(const Bitboard pieces[2][7], Color side);
+    // Append a FEN position. Returns false (and adds nothing) on bad input.
+    bool addFEN(const std::string& fen);
+
+    // Set up 'b' as position 'index' (for anything that needs a full Board)
+    void loadInto(size_t index, Board& b) const;
+    std::string toFEN(size_t index) const;
+
+    Bitboard pieces(size_t index, Color c, PieceType t) const { return pieceBB[c][t][index]; }
+    Color side(size_t index) const { return static_cast<Color>(sideToMove[index]); }
+
+    // Batch operations: 'out' is resized to size() and gets one entry per
+    // position, in order
+
+    // Material balance from White's point of view, middlegame and endgame
+    void materialScores(const EvalParameters& evalParams, std::vector<Score>& out) const;
+
+    // Material plus tapered piece-square scores (evaluateBoard without its pawn, imbalance and endgame terms)
+    void evalScores(const EvalParameters& evalParams, std::vector<int>& out) const;
+
+    // Every square attacked by 'side' (Board::attackedBy for every position)
+    void attackMaps(Color side, std::vector<Bitboard>& out) const;
+
+    // Number of legal moves of the side to move
+    void legalMoveCounts(std::vector<int>& out) const;
+
+private:
+    Bitboard occupied(size_t index) const;
+
+    std::vector<Bitboard> pieceBB[2][7]; // [color][piece type][position]; EMPTY unused
+    std::vector<uint8_t> sideToMove;
+    std::vector<uint8_t> castlingRights;
+    std::vector<int8_t> epSquare;
+    std::vector<uint16_t> halfmoveClock;
+};
+
+// Called by selectCpuPaths: the POPCNT material kernel when the CPU has it
+void selectBatchKernels(bool useExtensions);
+
+// Compares the POPCNT material kernel with the portable one on random
+// bitboards (part of runCpuSelfTest)
+bool batchKernelSelfTest();
+
+#endif // BOARDBATCH_H
@@ -35,15 +35,67 @@ struct Piece {
     }
 };
 
+// Moves that need more than "lift the piece, drop it on the target".
+// Promotions are identified by Move::promotion instead.
+enum MoveKind {
+    NORMAL_MOVE = 0,
+    CASTLING,   // king move of two squares; the rook is moved too
+    EN_PASSANT  // pawn capture onto the empty en-passant square
+};
+
 // A move structure: from-square, to-square, etc.
 struct Move {
     int fromRow, fromCol;
     int toRow, toCol;
     int score; // Used for sorting or alpha-beta internal scoring
+    PieceType promotion; // Piece a pawn promotes to, EMPTY for other moves
+    MoveKind kind;
+
+    Move(int fr = 0, int fc = 0, int tr = 0, int tc = 0, PieceType promo = EMPTY,
+        MoveKind k = NORMAL_MOVE)
+        : fromRow(fr), fromCol(fc), toRow(tr), toCol(tc), score(0), promotion(promo), kind(k) {
+    }
+
+    // Two moves are the same if they connect the same squares and promote
+    // to the same piece ('score' is ignored; 'kind' follows from the position)
+    bool operator==(const Move& other) const {
+        return fromRow == other.fromRow && fromCol == other.fromCol
+            && toRow == other.toRow && toCol == other.toCol
+            && promotion == other.promotion;
+    }
+
+    // Default-constructed moves (a1a1) mean "no move"
+    bool isNull() const {
+        return fromRow == toRow && fromCol == toCol;
+    }
+};
+
+// Fixed-capacity buffer the move generators append to. It lives on the
+// caller's stack, so generating moves in the search never allocates.
+struct MoveList {
+    static const int CAPACITY = 256; // no legal position has more than 218 moves
+
+    // In a union so the entries are not constructed when the list is made:
+    // only the first 'count' are ever read, and they were written by add()
+    union {
+        Move moves[CAPACITY];
+    };
+    int count;
 
-    Move(int fr = 0, int fc = 0, int tr = 0, int tc = 0)
-        : fromRow(fr), fromCol(fc), toRow(tr), toCol(tc), score(0) {
+    MoveList() : count(0) {
     }
+
+    void add(const Move& m) { moves[count++] = m; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](int i) { return moves[i]; }
+    const Move& operator[](int i) const { return moves[i]; }
+
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
 };
 
 #endif // CHESSTYPES_H
@@ -0,0 +1,154 @@
+#include "Cpu.h"
+#include "Bitboard.h"
+#include "BoardBatch.h"
+#include "Nnue.h"
+
+#include <iostream>
+#include <random>
+
+#if CPU_X86_64
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// --------------------------------------------------
+// Detection
+// --------------------------------------------------
+#if CPU_X86_64
+// regs = { eax, ebx, ecx, edx } of cpuid leaf/subleaf
+static void cpuid(int leaf, int subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, leaf, subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = static_cast<unsigned>(r[i]);
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3])) {
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    }
+#endif
+}
+
+// Register state the OS saves on a context switch (XCR0)
+static uint64_t enabledXState() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned lo, hi;
+    __asm__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+static CpuFeatures detectCpuFeatures() {
+    CpuFeatures f = {};
+#if CPU_X86_64
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    unsigned maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    f.sse41 = (regs[2] >> 19) & 1;
+    f.popcnt = (regs[2] >> 23) & 1;
+    bool osxsave = (regs[2] >> 27) & 1;
+
+    // The AVX flags only count if the OS saves the YMM (bits 1-2) and, for
+    // AVX-512, the mask and ZMM registers (bits 5-7) too
+    uint64_t xstate = osxsave ? enabledXState() : 0;
+    bool ymmSaved = (xstate & 0x06) == 0x06;
+    bool zmmSaved = (xstate & 0xE6) == 0xE6;
+
+    if (maxLeaf >= 7) {
+        cpuid(7, 0, regs);
+        f.bmi2 = (regs[1] >> 8) & 1;
+        f.avx2 = ymmSaved && ((regs[1] >> 5) & 1);
+        f.avx512 = zmmSaved && ((regs[1] >> 16) & 1) && ((regs[1] >> 30) & 1);
+        f.avx512Vnni = f.avx512 && ((regs[2] >> 11) & 1);
+
+        cpuid(7, 1, regs);
+        f.avxVnni = f.avx2 && ((regs[0] >> 4) & 1);
+    }
+#endif
+    return f;
+}
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+std::string cpuFeatureString() {
+    const CpuFeatures& f = cpuFeatures();
+    std::string s;
+    if (f.sse41) s += "sse4.1 ";
+    if (f.popcnt) s += "popcnt ";
+    if (f.bmi2) s += "bmi2 ";
+    if (f.avx2) s += "avx2 ";
+    if (f.avx512) s += "avx512 ";
+    if (f.avx512Vnni) s += "avx512vnni ";
+    if (f.avxVnni) s += "avxvnni ";
+    if (s.empty()) return "none";
+    s.pop_back();
+    return s;
+}
+
+// --------------------------------------------------
+// Dispatch
+// --------------------------------------------------
+void selectCpuPaths(bool useExtensions) {
+    if (useExtensions && cpuFeatures().bmi2) {
+        initPextSliders();
+        sliderPath = SLIDER_PEXT;
+    }
+    else {
+        sliderPath = SLIDER_RAYS;
+    }
+    selectNnueKernels(useExtensions);
+    selectBatchKernels(useExtensions);
+}
+
+// Pick the paths before main() runs. Only variables of Bitboard.cpp, Nnue.cpp
+// and BoardBatch.cpp are touched and they are constant- or zero-initialized,
+// so the order of the static initializers across files does not matter.
+static const bool cpuPathsSelected = (selectCpuPaths(true), true);
+
+// --------------------------------------------------
+// Self-test
+// --------------------------------------------------
+bool runCpuSelfTest() {
+    bool ok = true;
+    std::mt19937_64 rng(20240601);
+
+    // Sparse, medium and dense occupancies on every square
+    if (cpuFeatures().bmi2) {
+        initPextSliders();
+        int mismatches = 0;
+        for (int sq = 0; sq < 64; sq++) {
+            for (int i = 0; i < 3000; i++) {
+                Bitboard occupied = rng();
+                if (i % 3 == 0) occupied &= rng() & rng();
+                else if (i % 3 == 1) occupied &= rng();
+                if (pextRookAttacks(sq, occupied) != rayRookAttacks(sq, occupied)
+                    || pextBishopAttacks(sq, occupied) != rayBishopAttacks(sq, occupied)) {
+                    if (mismatches++ == 0) {
+                        std::cout << "PEXT slider mismatch on square " << sq
+                            << " occupancy " << std::hex << occupied << std::dec << "\n";
+                    }
+                }
+            }
+        }
+        std::cout << "PEXT sliders    : " << (mismatches ? "FAILED" : "ok") << "\n";
+        ok = ok && mismatches == 0;
+    }
+    else {
+        std::cout << "PEXT sliders    : skipped (no BMI2)\n";
+    }
+
+    ok = batchKernelSelfTest() && ok;
+    ok = nnueKernelSelfTest() && ok;
+
+    return ok;
+}
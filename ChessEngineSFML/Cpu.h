@@ -0,0 +1,62 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <string>
+
+// --------------------------------------------------
+// CPU feature detection and dispatch
+// --------------------------------------------------
+// One executable for every x86-64 machine: the instruction set extensions are
+// detected once at startup, and code with a faster path for an extension
+// selects it from here instead of needing a -march=native build. Every such
+// path keeps a portable fallback, and runCpuSelfTest() checks they agree.
+
+struct CpuFeatures {
+    bool sse41;
+    bool popcnt;
+    bool bmi2;       // PEXT / PDEP
+    bool avx2;
+    bool avx512;     // AVX-512 F and BW
+    bool avx512Vnni; // int8 dot products on 512-bit registers
+    bool avxVnni;    // the same on 256-bit registers, without AVX-512
+};
+
+// Detected on first call (the OS must also save the wide registers for the
+// AVX flags to be set)
+const CpuFeatures& cpuFeatures();
+
+// e.g. "popcnt bmi2 avx2"
+std::string cpuFeatureString();
+
+// Selects the fastest implementation of each dispatched routine for this CPU.
+// Runs automatically at startup; callable again to restrict the choice, e.g.
+// selectCpuPaths(false) forces every portable fallback for comparisons.
+void selectCpuPaths(bool useExtensions);
+
+// Runs every accelerated path the CPU supports against its fallback on
+// exhaustive or random inputs. Returns false (and prints why) on a mismatch.
+bool runCpuSelfTest();
+
+// How a function is marked as allowed to use an extension. MSVC lets any
+// function use the intrinsics; GCC and Clang need a target attribute.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TARGET_SSE41
+#define TARGET_POPCNT
+#define TARGET_BMI2
+#define TARGET_AVX2
+#define TARGET_AVX512_VNNI
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_POPCNT __attribute__((target("popcnt")))
+#define TARGET_BMI2 __attribute__((target("bmi2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512_VNNI __attribute__((target("avx512f,avx512bw,avx512vnni")))
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CPU_X86_64 1
+#else
+#define CPU_X86_64 0
+#endif
+
+#endif // CPU_H
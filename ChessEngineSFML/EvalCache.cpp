@@ -0,0 +1,46 @@
+#include "EvalCache.h"
+
+// The slot index comes from the low bits of the key and the check from the
+// high ones, so even the largest table leaves 32 bits to tell keys apart.
+// An empty slot holds 0, which a key whose upper half is 0 with a score of
+// 0 would also produce: that one position is never found, harmlessly.
+static inline uint64_t packEntry(uint64_t key, int eval) {
+    return (key & 0xFFFFFFFF00000000ULL) | static_cast<uint32_t>(eval);
+}
+
+EvalCache::EvalCache(size_t sizeMB)
+    : table(), mask(0) {
+    resize(sizeMB);
+}
+
+// Round the entry count down to a power of two so indexing is a single AND
+void EvalCache::resize(size_t sizeMB) {
+    size_t entries = (sizeMB * 1024 * 1024) / sizeof(uint64_t);
+    size_t count = 1;
+    while (count * 2 <= entries) {
+        count *= 2;
+    }
+    std::vector<std::atomic<uint64_t>> fresh(count);
+    table.swap(fresh);
+    mask = count - 1;
+    clear();
+}
+
+void EvalCache::clear() {
+    for (auto& slot : table) {
+        slot.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool EvalCache::probe(uint64_t key, int& eval) const {
+    uint64_t entry = table[key & mask].load(std::memory_order_relaxed);
+    if (entry != 0 && (entry & 0xFFFFFFFF00000000ULL) == (key & 0xFFFFFFFF00000000ULL)) {
+        eval = static_cast<int32_t>(static_cast<uint32_t>(entry));
+        return true;
+    }
+    return false;
+}
+
+void EvalCache::store(uint64_t key, int eval) {
+    table[key & mask].store(packEntry(key, eval), std::memory_order_relaxed);
+}
@@ -0,0 +1,35 @@
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Static evaluations by Zobrist key. Quiescence, the iterations of iterative
+// deepening and the MultiPV sub-searches evaluate many positions again; a
+// probe is one memory read instead of a full evaluation.
+//
+// Each slot is a single 64-bit word, the upper half of the key and the
+// score, read and written with one atomic access. A reader therefore never
+// sees the key of one store with the score of another, and the table can be
+// shared between threads without locks. Scores are from the side to move's
+// point of view.
+class EvalCache {
+public:
+    explicit EvalCache(size_t sizeMB = 4);
+
+    void resize(size_t sizeMB);
+    void clear();
+
+    // Returns true and fills 'eval' when the key is present
+    bool probe(uint64_t key, int& eval) const;
+
+    void store(uint64_t key, int eval);
+
+private:
+    std::vector<std::atomic<uint64_t>> table;
+    size_t mask;
+};
+
+#endif // EVALCACHE_H
@@ -1,114 +1,157 @@
 #include "Evaluation.h"
-#include <cmath>      // for std::abs
-#include <algorithm>  // for std::sort
-#include <iostream>   // for std::cout, debugging
-#include <ctime>
+#include "Material.h"
+#include "Pawns.h"
+#include "Psqt.h"
 
-int evaluateBoard(const Board& b, const EvalParameters& evalParams) {
-    int score = 0;
-    for (int r = 0; r < Board::SIZE; r++) {
-        for (int c = 0; c < Board::SIZE; c++) {
-            const Piece& p = b.board[r][c];
-            int val = 0;
-            switch (p.type) {
-            case PAWN:   val = evalParams.pawnValue;   break;
-            case KNIGHT: val = evalParams.knightValue; break;
-            case BISHOP: val = evalParams.bishopValue; break;
-            case ROOK:   val = evalParams.rookValue;   break;
-            case QUEEN:  val = evalParams.queenValue;  break;
-            default:     val = 0;                      break;
-            }
-            if (p.color == BLACK) {
-                val = -val;
-            }
-            score += val;
+#include <algorithm> // for std::min
+#include <limits>
+
+// Passed pawns with nothing at all in front of them, by relative rank
+static constexpr Score PASSED_FREE_PATH[8] = {
+    S(0, 0), S(0, 0), S(0, 2), S(0, 6), S(0, 14), S(0, 28), S(0, 48), S(0, 0)
+};
+
+Score pieceScore(PieceType type, const EvalParameters& evalParams) {
+    switch (type) {
+    case PAWN:   return evalParams.pawnValue;
+    case KNIGHT: return evalParams.knightValue;
+    case BISHOP: return evalParams.bishopValue;
+    case ROOK:   return evalParams.rookValue;
+    case QUEEN:  return evalParams.queenValue;
+    default:     return SCORE_ZERO;
+    }
+}
+
+int pieceValue(PieceType type, const EvalParameters& evalParams) {
+    return mgValue(pieceScore(type, evalParams));
+}
+
+// The pawn table knows which pawns are passed; whether their path is clear
+// depends on the other pieces too, so it is checked here. Passed pawns are
+// few, so this is a short loop over their front spans.
+template <Color Us>
+static Score passedPathScore(const Board& b, Bitboard passed) {
+    Bitboard occupied = b.colorBB[WHITE] | b.colorBB[BLACK];
+    Score score = SCORE_ZERO;
+    while (passed) {
+        int sq = popLsb(passed);
+        if (!(frontSpans<Us>(squareBB(sq)) & occupied)) {
+            score += PASSED_FREE_PATH[(Us == WHITE) ? rowOf(sq) : 7 - rowOf(sq)];
         }
     }
     return score;
 }
 
-EvalParameters mutateParameters(const EvalParameters& params) {
-    static std::mt19937 rng(static_cast<unsigned>(time(nullptr)));
-    std::uniform_int_distribution<int> dist(-10, 10);
+// --------------------------------------------------
+// Pieces: mobility, king safety and threats
+// --------------------------------------------------
+// Mobility counts the squares a piece attacks that are not taken by its own
+// pawns or king and not attacked by enemy pawns, scored per square above or
+// below a typical count for the piece type
+static constexpr Score MOBILITY_WEIGHT[7] = {
+    S(0, 0), S(0, 0), S(4, 4), S(5, 5), S(2, 4), S(1, 2), S(0, 0)
+};
+static constexpr int MOBILITY_CENTER[7] = { 0, 0, 4, 6, 6, 12, 0 };
 
-    EvalParameters newParams = params;
-    newParams.pawnValue += dist(rng);
-    newParams.knightValue += dist(rng);
-    newParams.bishopValue += dist(rng);
-    newParams.rookValue += dist(rng);
-    newParams.queenValue += dist(rng);
+// King safety: each piece attacking the enemy king's zone (the king's
+// square and its neighbours) adds its weight per zone square it hits. The
+// penalty grows with the square of the total, once at least two pieces
+// take part.
+static constexpr int KING_ATTACK_WEIGHT[7] = { 0, 0, 2, 2, 3, 5, 0 };
+static constexpr int KING_DANGER_MAX = 500;
 
-    return newParams;
-}
+static constexpr Score THREAT_BY_PAWN = S(40, 30);  // a piece attacked by a pawn
+static constexpr Score THREAT_BY_MINOR = S(25, 20); // a rook or queen attacked by a minor piece
+static constexpr Score HANGING = S(20, 15);         // attacked and not defended at all
+
+// Everything is read from the board's attack maps, built once per position
+template <Color Us>
+static Score evaluatePieces(const Board& b, const Board::AttackMaps& maps) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
 
-// Create random boards for testing (very simplistic)
-std::vector<Board> createRandomTestPositions(int numPositions) {
-    std::vector<Board> positions;
-    positions.reserve(numPositions);
+    Bitboard mobilityArea = ~(b.pieceBB[Us][PAWN] | b.pieceBB[Us][KING] | maps.byType[Them][PAWN]);
+    Bitboard kingZone = b.pieceBB[Them][KING] ? kingAttacks(lsb(b.pieceBB[Them][KING])) | b.pieceBB[Them][KING] : 0;
 
-    for (int i = 0; i < numPositions; i++) {
-        // For now, just push standard boards, or do minimal randomization
-        Board b;
-        positions.push_back(b);
+    Score score = SCORE_ZERO;
+    int kingAttackers = 0;
+    int kingAttackUnits = 0;
+    for (int t = KNIGHT; t <= QUEEN; t++) {
+        for (Bitboard x = b.pieceBB[Us][t]; x; ) {
+            Bitboard attacks = maps.byPiece[popLsb(x)];
+            score += MOBILITY_WEIGHT[t] * (popCount(attacks & mobilityArea) - MOBILITY_CENTER[t]);
+            if (attacks & kingZone) {
+                kingAttackers++;
+                kingAttackUnits += KING_ATTACK_WEIGHT[t] * popCount(attacks & kingZone);
+            }
+        }
+    }
+    if (kingAttackers >= 2) {
+        int danger = std::min(kingAttackUnits * kingAttackUnits / 4, KING_DANGER_MAX);
+        score += S(danger, danger / 8);
     }
-    return positions;
+
+    Bitboard targets = b.colorBB[Them] & ~b.pieceBB[Them][KING];
+    score += THREAT_BY_PAWN * popCount(targets & ~b.pieceBB[Them][PAWN] & maps.byType[Us][PAWN]);
+    score += THREAT_BY_MINOR * popCount((b.pieceBB[Them][ROOK] | b.pieceBB[Them][QUEEN])
+        & (maps.byType[Us][KNIGHT] | maps.byType[Us][BISHOP]));
+    score += HANGING * popCount(targets & maps.byType[Us][EMPTY] & ~maps.byType[Them][EMPTY]);
+    return score;
 }
 
-// Evaluate candidate on test positions
-double measureFitness(const Candidate& cand, const std::vector<Board>& testPositions) {
-    double sumScores = 0.0;
-    for (const auto& b : testPositions) {
-        int score = evaluateBoard(b, cand.params);
-        // We'll do a silly metric: prefer eval near 0 
-        // to avoid big +/- swings: fitness = -abs(score)/100
-        sumScores -= std::abs(score) / 100.0;
-    }
-    return sumScores;
+// --------------------------------------------------
+// Evaluation
+// --------------------------------------------------
+// How far the terms of each tier can move the final score, in centipawns.
+// Over 30000 self-play positions, the piece terms moved it by at most 201 in
+// 9999 cases of 10000 (and 263 in the worst one); the margin leaves room
+// above that for positions unlike the sample.
+static constexpr int TIER_MARGIN[EVAL_TIER_COUNT] = { 275 };
+
+// Is 'value' outside the window even if the remaining tiers move it by up to 'margin'?
+static bool outsideWindow(int value, int margin, int alpha, int beta) {
+    return value + margin <= alpha || value - margin >= beta;
 }
 
-EvalParameters trainEvalParameters(int generations, int populationSize, int testPositionsCount) {
-    // 1) Create initial population
-    std::mt19937 rng(static_cast<unsigned>(time(nullptr)));
-    std::uniform_int_distribution<int> distBase(80, 120); // near typical values
-
-    std::vector<Candidate> population(populationSize);
-    for (int i = 0; i < populationSize; i++) {
-        population[i].params.pawnValue = distBase(rng);
-        population[i].params.knightValue = distBase(rng) * 3;
-        population[i].params.bishopValue = distBase(rng) * 3;
-        population[i].params.rookValue = distBase(rng) * 5;
-        population[i].params.queenValue = distBase(rng) * 9;
-        population[i].fitness = 0.0;
-    }
+int evaluateBoard(const Board& b, const EvalParameters& evalParams) {
+    EvalTierStats stats = {};
+    return evaluateBoard(b, evalParams, std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), stats);
+}
 
-    // 2) Make test positions
-    auto testPositions = createRandomTestPositions(testPositionsCount);
+int evaluateBoard(const Board& b, const EvalParameters& evalParams, int alpha, int beta, EvalTierStats& stats) {
+    // Material, imbalance, phase and endgame knowledge come from the
+    // material table, pawn structure and king shelter from the pawn table,
+    // and the piece-square scores are kept by Board; only mobility, king
+    // safety and threats look at the pieces, through the attack maps. Both
+    // halves are summed together and blended once at the end.
+    stats.evaluations++;
+    MaterialEntry* material = materialTable().probe(b, evalParams);
+    if (material->endgame) {
+        return material->endgame(b, *material);
+    }
+    Score score = b.psq + material->score;
+    auto blended = [&]() {
+        Color ahead = (egValue(score) >= 0) ? WHITE : BLACK;
+        return taper(score, material->phase, material->scaleFactor(b, ahead));
+    };
 
-    // 3) Evolution loop
-    for (int gen = 0; gen < generations; gen++) {
-        // Evaluate each candidate
-        for (auto& cand : population) {
-            cand.fitness = measureFitness(cand, testPositions);
-        }
+    // Pawn structure is never skipped: a miss is computed and stored, so the
+    // pawn table keeps filling however narrow the windows are
+    PawnEntry* pawns = pawnTable().probe(b);
+    score += pawns->score;
+    if (b.pieceCount[WHITE][KING] && b.pieceCount[BLACK][KING]) {
+        score += pawns->kingShelter(b, WHITE, b.pieceList[WHITE][KING][0])
+            - pawns->kingShelter(b, BLACK, b.pieceList[BLACK][KING][0]);
+    }
+    score += passedPathScore<WHITE>(b, pawns->passed[WHITE]) - passedPathScore<BLACK>(b, pawns->passed[BLACK]);
 
-        // Sort by fitness descending
-        std::sort(population.begin(), population.end(),
-            [](const Candidate& a, const Candidate& b) {
-                return a.fitness > b.fitness;
-            });
-
-        // Print best for debug
-        std::cout << "Gen " << gen
-            << " best fitness: " << population[0].fitness << std::endl;
-
-        // Keep top half, mutate to fill the bottom half
-        int survivors = populationSize / 2;
-        for (int i = survivors; i < populationSize; i++) {
-            population[i].params = mutateParameters(
-                population[i - survivors].params
-            );
-        }
+    // Piece tier: building the attack maps is most of the evaluation's cost
+    int value = blended();
+    if (outsideWindow(value, TIER_MARGIN[EVAL_TIER_PIECES], alpha, beta)) {
+        stats.skipped[EVAL_TIER_PIECES]++;
+        return value;
     }
+    const Board::AttackMaps& maps = b.attackMaps();
+    score += evaluatePieces<WHITE>(b, maps) - evaluatePieces<BLACK>(b, maps);
 
-    return population[0].params;
+    return blended();
 }
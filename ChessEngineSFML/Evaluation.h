@@ -2,32 +2,53 @@
 #define EVALUATION_H
 
 #include "Board.h" // we need Board, Piece, etc.
-#include <random>
 
-// Simple piece-value structure
+#include <cstdint>
+
+// Simple piece-value structure: each value is a middlegame/endgame pair
+// (Score.h), blended by game phase when a position is evaluated
 struct EvalParameters {
-    int pawnValue;
-    int knightValue;
-    int bishopValue;
-    int rookValue;
-    int queenValue;
+    Score pawnValue;
+    Score knightValue;
+    Score bishopValue;
+    Score rookValue;
+    Score queenValue;
 };
 
-// For evolving (training)  a struct that holds parameters + fitness
-struct Candidate {
-    EvalParameters params;
-    double fitness;
+// Plain piece values; the piece-square tables carry the rest
+constexpr EvalParameters DEFAULT_EVAL_PARAMETERS = {
+    S(100, 100), S(300, 300), S(300, 300), S(500, 500), S(900, 900)
 };
 
-// Evaluate a board with the given parameters (material only, naive)
+// Material value of one piece type (kings are worth 0)
+Score pieceScore(PieceType type, const EvalParameters& evalParams);
+
+// Its middlegame half, for code that needs a single number (exchange
+// evaluation, move ordering)
+int pieceValue(PieceType type, const EvalParameters& evalParams);
+
+// Evaluate a board with the given parameters: material and imbalance
+// (Material.h), the piece-square tables and pawn structure (Pawns.h) blended
+// by game phase, with the endgame half scaled down in drawish endings and
+// known endings handed to their own evaluators; from White's point of view
 int evaluateBoard(const Board& b, const EvalParameters& evalParams);
 
-// Mutate parameters randomly
-EvalParameters mutateParameters(const EvalParameters& params);
+// The expensive parts of evaluateBoard, in the order they are added
+enum EvalTier {
+    EVAL_TIER_PIECES, // mobility, king safety and threats
+    EVAL_TIER_COUNT
+};
+
+struct EvalTierStats {
+    uint64_t evaluations;
+    uint64_t skipped[EVAL_TIER_COUNT];
+};
 
-// Functions for training (very simplified)
-std::vector<Board> createRandomTestPositions(int numPositions);
-double measureFitness(const Candidate& cand, const std::vector<Board>& testPositions);
-EvalParameters trainEvalParameters(int generations, int populationSize, int testPositionsCount);
+// Lazy evaluateBoard for a search window (White's point of view). Before
+// each tier, the score so far is returned as it is when the tier and the
+// ones after it could not bring it back inside [alpha, beta]; the result is
+// then only a bound, on the same side of the window as the exact score.
+// Each skip is counted in 'stats'.
+int evaluateBoard(const Board& b, const EvalParameters& evalParams, int alpha, int beta, EvalTierStats& stats);
 
 #endif // EVALUATION_H
@@ -0,0 +1,198 @@
+#include "Material.h"
+
+#include <algorithm> // for std::fill, std::min
+#include <cstdlib>   // for std::abs
+#include <cstring>   // for std::memcmp
+
+// --------------------------------------------------
+// Imbalance
+// --------------------------------------------------
+static constexpr Score BISHOP_PAIR = S(25, 45);
+
+// Per own pawn above five: knights gain from a closed board, rooks from an
+// open one
+static constexpr Score KNIGHT_PER_PAWN = S(4, 6);
+static constexpr Score ROOK_PER_PAWN = S(-8, -12);
+
+static Score imbalance(const int count[7]) {
+    Score score = (count[BISHOP] >= 2) ? BISHOP_PAIR : SCORE_ZERO;
+    score += KNIGHT_PER_PAWN * (count[KNIGHT] * (count[PAWN] - 5));
+    score += ROOK_PER_PAWN * (count[ROOK] * (count[PAWN] - 5));
+    return score;
+}
+
+// --------------------------------------------------
+// Endgames
+// --------------------------------------------------
+static constexpr int KNOWN_WIN = 1000;
+static constexpr int OPPOSITE_BISHOPS_SCALE = 24;
+static constexpr int ONE_PAWN_SCALE = 48;
+
+// 0 in the centre, 120 in a corner
+static int pushToEdge(int sq) {
+    int file = std::min(colOf(sq), 7 - colOf(sq));
+    int rank = std::min(rowOf(sq), 7 - rowOf(sq));
+    return 20 * (6 - file - rank);
+}
+
+static int pushClose(int a, int b) {
+    return 10 * (7 - squareDistance(a, b));
+}
+
+// Enough material against a bare king: drive the king to the edge and
+// bring our own king in. Pawns and extra pieces only add to the score.
+static int evaluateKXK(const Board& b, const MaterialEntry& material) {
+    Color strong = material.strongSide;
+    Color weak = (strong == WHITE) ? BLACK : WHITE;
+    int strongKing = b.pieceList[strong][KING][0];
+    int weakKing = b.pieceList[weak][KING][0];
+
+    // Bishops alone, all on squares of one color, cannot mate however many
+    // there are. Their squares are not in the material key, so this is
+    // checked here rather than when the entry is made.
+    Bitboard bishops = b.pieceBB[strong][BISHOP];
+    if (!b.pieceCount[strong][PAWN] && !b.pieceCount[strong][KNIGHT] && !b.pieceCount[strong][ROOK]
+        && !b.pieceCount[strong][QUEEN] && (!(bishops & DARK_SQUARES_BB) || !(bishops & ~DARK_SQUARES_BB))) {
+        return 0;
+    }
+
+    int value = std::abs(egValue(material.score)) + pushToEdge(weakKing) + pushClose(strongKing, weakKing);
+    if (b.pieceCount[strong][QUEEN] || b.pieceCount[strong][ROOK] || b.pieceCount[strong][BISHOP] >= 2
+        || (b.pieceCount[strong][BISHOP] && b.pieceCount[strong][KNIGHT])) {
+        value += KNOWN_WIN;
+    }
+    return (strong == WHITE) ? value : -value;
+}
+
+// Two knights against a bare king: no mate can be forced
+static int evaluateKNNK(const Board&, const MaterialEntry&) {
+    return 0;
+}
+
+// Bishop and knight against a bare king: the mate only works in a corner of
+// the bishop's color, so the king is driven there rather than to any edge
+static int evaluateKBNK(const Board& b, const MaterialEntry& material) {
+    Color strong = material.strongSide;
+    Color weak = (strong == WHITE) ? BLACK : WHITE;
+    int strongKing = b.pieceList[strong][KING][0];
+    int weakKing = b.pieceList[weak][KING][0];
+
+    bool dark = (b.pieceBB[strong][BISHOP] & DARK_SQUARES_BB) != 0;
+    int cornerA = dark ? squareOf(0, 0) : squareOf(0, 7);
+    int cornerB = dark ? squareOf(7, 7) : squareOf(7, 0);
+    int cornerDistance = std::min(squareDistance(weakKing, cornerA), squareDistance(weakKing, cornerB));
+
+    int value = KNOWN_WIN + std::abs(egValue(material.score)) + 30 * (7 - cornerDistance)
+        + pushClose(strongKing, weakKing);
+    return (strong == WHITE) ? value : -value;
+}
+
+int MaterialEntry::scaleFactor(const Board& b, Color strong) const {
+    if (oppositeBishopCandidate && factor[strong] == SCALE_NORMAL) {
+        Bitboard bishops = b.pieceBB[WHITE][BISHOP] | b.pieceBB[BLACK][BISHOP];
+        if ((bishops & DARK_SQUARES_BB) && (bishops & ~DARK_SQUARES_BB)) {
+            return OPPOSITE_BISHOPS_SCALE;
+        }
+    }
+    return factor[strong];
+}
+
+// --------------------------------------------------
+// Table
+// --------------------------------------------------
+static void computeEntry(const Board& b, const EvalParameters& evalParams, MaterialEntry* e) {
+    const int (&count)[2][7] = b.pieceCount;
+
+    Score score = SCORE_ZERO;
+    int phase = 0;
+    int nonPawn[2] = { 0, 0 }; // middlegame value of the pieces other than pawns
+    for (int t = PAWN; t <= QUEEN; t++) {
+        Score value = pieceScore(static_cast<PieceType>(t), evalParams);
+        score += (count[WHITE][t] - count[BLACK][t]) * value;
+        phase += (count[WHITE][t] + count[BLACK][t]) * PHASE_WEIGHTS[t];
+        if (t != PAWN) {
+            nonPawn[WHITE] += count[WHITE][t] * mgValue(value);
+            nonPawn[BLACK] += count[BLACK][t] * mgValue(value);
+        }
+    }
+    score += imbalance(count[WHITE]) - imbalance(count[BLACK]);
+
+    e->score = score;
+    e->phase = static_cast<int16_t>(std::min(phase, PHASE_MAX));
+    int pawnValue = mgValue(evalParams.pawnValue);
+    e->strongSide = (nonPawn[WHITE] + count[WHITE][PAWN] * pawnValue
+        >= nonPawn[BLACK] + count[BLACK][PAWN] * pawnValue) ? WHITE : BLACK;
+
+    // Without pawns, a piece up is not enough to win unless it is at least
+    // a rook; with a single pawn that can be traded off it is harder too
+    int bishopValue = mgValue(evalParams.bishopValue);
+    int rookValue = mgValue(evalParams.rookValue);
+    for (int c = WHITE; c <= BLACK; c++) {
+        int them = c ^ 1;
+        int factor = SCALE_NORMAL;
+        if (nonPawn[c] - nonPawn[them] <= bishopValue) {
+            if (count[c][PAWN] == 0) {
+                factor = (nonPawn[c] < rookValue) ? 0 : (nonPawn[them] <= bishopValue) ? 4 : 14;
+            }
+            else if (count[c][PAWN] == 1) {
+                factor = ONE_PAWN_SCALE;
+            }
+        }
+        e->factor[c] = static_cast<uint8_t>(factor);
+    }
+
+    auto onlyBishop = [&](int c) {
+        return count[c][BISHOP] == 1 && !count[c][KNIGHT] && !count[c][ROOK] && !count[c][QUEEN];
+    };
+    e->oppositeBishopCandidate = onlyBishop(WHITE) && onlyBishop(BLACK);
+
+    // Specialized endgames against a bare king
+    Color strong = e->strongSide;
+    Color weak = (strong == WHITE) ? BLACK : WHITE;
+    e->endgame = nullptr;
+    if (nonPawn[weak] == 0 && count[weak][PAWN] == 0 && count[WHITE][KING] == 1 && count[BLACK][KING] == 1) {
+        if (count[strong][PAWN] == 0 && count[strong][BISHOP] == 1 && count[strong][KNIGHT] == 1
+            && !count[strong][ROOK] && !count[strong][QUEEN]) {
+            e->endgame = evaluateKBNK;
+        }
+        else if (count[strong][PAWN] == 0 && count[strong][KNIGHT] == 2 && !count[strong][BISHOP]
+            && !count[strong][ROOK] && !count[strong][QUEEN]) {
+            e->endgame = evaluateKNNK;
+        }
+        else if (nonPawn[strong] >= rookValue) {
+            e->endgame = evaluateKXK;
+        }
+    }
+}
+
+// An all-zero slot is the entry of a board without any pieces (no
+// material, a dead draw), the one position material key 0 stands for, so
+// slots need no valid flag
+MaterialTable::MaterialTable(size_t entries)
+    : mask(0), params() {
+    size_t count = 1;
+    while (count * 2 <= entries) {
+        count *= 2;
+    }
+    table.assign(count, MaterialEntry());
+    mask = count - 1;
+}
+
+MaterialEntry* MaterialTable::probe(const Board& b, const EvalParameters& evalParams) {
+    if (std::memcmp(&evalParams, &params, sizeof(EvalParameters)) != 0) {
+        std::fill(table.begin(), table.end(), MaterialEntry());
+        params = evalParams;
+    }
+
+    MaterialEntry* e = &table[b.materialKey & mask];
+    if (e->key != b.materialKey) {
+        e->key = b.materialKey;
+        computeEntry(b, evalParams, e);
+    }
+    return e;
+}
+
+MaterialTable& materialTable() {
+    static thread_local MaterialTable table;
+    return table;
+}
@@ -0,0 +1,56 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "Evaluation.h" // we need Board, EvalParameters
+
+#include <cstdint>
+#include <vector>
+
+// --------------------------------------------------
+// Material
+// --------------------------------------------------
+// Everything evaluation derives from the piece counts alone: the material
+// score, imbalance terms, the game phase, how much of the endgame score
+// each side can expect to convert, and whether a specialized endgame
+// evaluator applies. Positions with the same counts share one entry, keyed
+// by Board::materialKey, so the leaves do no material arithmetic at all.
+
+struct MaterialEntry;
+
+// A specialized evaluation of a known ending, from White's point of view
+typedef int (*EndgameFunction)(const Board& b, const MaterialEntry& material);
+
+struct MaterialEntry {
+    uint64_t key;
+    Score score;    // material and imbalance, White minus Black
+    int16_t phase;  // PHASE_MAX in the opening, 0 with only kings and pawns
+    uint8_t factor[2]; // scale factor of the endgame half when that color is ahead
+    bool oppositeBishopCandidate; // one bishop each and nothing else but pawns
+    Color strongSide; // the side with more material
+    EndgameFunction endgame; // nullptr when no specialized evaluator applies
+
+    // The scale factor for the side 'strong' being ahead. Whether the
+    // bishops are on opposite colors depends on their squares, so that one
+    // is checked here, per position.
+    int scaleFactor(const Board& b, Color strong) const;
+};
+
+class MaterialTable {
+public:
+    explicit MaterialTable(size_t entries = 8192); // rounded down to a power of two
+
+    // The entry for the piece counts of 'b', computed first if it is not in
+    // the table. Entries depend on the piece values, so a table probed with
+    // other values than last time starts over.
+    MaterialEntry* probe(const Board& b, const EvalParameters& evalParams);
+
+private:
+    std::vector<MaterialEntry> table;
+    size_t mask;
+    EvalParameters params;
+};
+
+// The calling thread's material table
+MaterialTable& materialTable();
+
+#endif // MATERIAL_H
@@ -1,81 +1,622 @@
 #include "Minimax.h"
+#include "EvalCache.h"
+#include "Nnue.h"
+#include "See.h"
+#include "TranspositionTable.h"
+
+#include <algorithm> // for std::max, std::rotate, std::find, std::stable_sort
+#include <cstdlib>   // for std::abs
+#include <cstring>   // for std::memcmp
 #include <limits>
 
-int alphaBeta(Board& b, int depth, int alpha, int beta, const EvalParameters& evalParams) {
-    if (depth == 0) {
-        return evaluateBoard(b, evalParams);
+static const int INF_SCORE = 1000000;
+
+// Depth is counted in fractions of a ply inside the search so that
+// extensions can be worth less than a full ply
+static const int ONE_PLY = 4;
+static const int CHECK_EXTENSION = 3;           // 3/4 ply
+static const int RECAPTURE_EXTENSION = 2;       // 1/2 ply
+static const int SINGULAR_EXTENSION = ONE_PLY;  // full ply
+static const int SINGULAR_MIN_DEPTH = 4 * ONE_PLY;
+static const int SINGULAR_MARGIN_PER_PLY = 20;  // centipawns
+static const int PROBCUT_MIN_DEPTH = 5 * ONE_PLY;
+static const int PROBCUT_REDUCTION = 4 * ONE_PLY;
+static const int QUIET_ORDER_MIN_DEPTH = 3 * ONE_PLY;
+
+static int probCutMargin = 200;
+static SearchStats lastStats = {};
+
+// One table for the whole program: MultiPV sub-searches and successive
+// iterations all reuse each other's entries
+static TranspositionTable tt;
+
+// Static evals, shared the same way. What they were computed with is
+// remembered so a search with other parameters or another network starts
+// from an empty cache. The classical evaluation reads most of its terms from
+// Board's sums and the pawn and material tables; even with mobility and king
+// safety it costs about as much as a probe that misses the CPU cache (bench:
+// no faster with it at a 23% hit rate), so only NNUE scores are cached.
+static EvalCache evalCache;
+static bool evalCacheUsed = false;
+static EvalParameters evalCacheParams = {};
+static bool evalCacheNnue = false;
+static uint32_t evalCacheNetwork = 0;
+
+static void prepareEvalCache(const EvalParameters& evalParams) {
+    evalCacheUsed = useNnue();
+    if (std::memcmp(&evalParams, &evalCacheParams, sizeof(EvalParameters)) != 0
+        || evalCacheNnue != useNnue() || evalCacheNetwork != nnueNetworkGeneration()) {
+        evalCache.clear();
+        evalCacheParams = evalParams;
+        evalCacheNnue = useNnue();
+        evalCacheNetwork = nnueNetworkGeneration();
     }
+}
+
+// Per-ply information about the current line
+struct SearchStackEntry {
+    Move move;          // Move made at this ply
+    bool capture;       // ...and whether it captured
+    Move excludedMove;  // Move skipped by a singular-extension verification search
+};
+
+// State threaded through one search
+struct SearchContext {
+    const EvalParameters& evalParams;
+    int rootDepth; // Nominal depth of the current iteration, in plies
+    SearchStats stats;
+
+    // Triangular PV table: row 'ply' holds the best line found from that ply
+    std::vector<Move> pvTable;
+    int pvLength[MAX_PLY + 1];
 
-    std::vector<Move> moves = b.generateMoves();
-    if (moves.empty()) {
-        // No moves -> checkmate/stalemate
-        // Just return static eval in this simplistic approach
-        return evaluateBoard(b, evalParams);
+    SearchStackEntry stack[MAX_PLY + 1];
+
+    explicit SearchContext(const EvalParameters& params)
+        : evalParams(params), rootDepth(0), stats(), pvTable(MAX_PLY * MAX_PLY), pvLength(), stack() {
     }
+};
 
-    if (b.sideToMove == WHITE) {
-        int value = -999999;
-        for (auto& m : moves) {
-            Piece captured = b.board[m.toRow][m.toCol];
-            b.makeMove(m);
+// Static eval from the side to move's point of view. NNUE scores come from
+// the eval cache when the position has been evaluated before. A classical
+// evaluation given a window [alpha, beta] may skip its expensive tiers when
+// they cannot bring the score inside it (the result is then only a bound).
+static int evaluateForSideToMove(const Board& b, SearchContext& ctx,
+    int alpha = -INF_SCORE, int beta = INF_SCORE)
+{
+    if (!evalCacheUsed) {
+        if (b.sideToMove == WHITE) {
+            return evaluateBoard(b, ctx.evalParams, alpha, beta, ctx.stats.evalTiers);
+        }
+        return -evaluateBoard(b, ctx.evalParams, -beta, -alpha, ctx.stats.evalTiers);
+    }
 
-            value = std::max(value, alphaBeta(b, depth - 1, alpha, beta, evalParams));
+    int eval;
+    ctx.stats.evalCacheProbes++;
+    if (evalCache.probe(b.hash, eval)) {
+        ctx.stats.evalCacheHits++;
+        return eval;
+    }
+    eval = nnueEvaluate(b);
+    evalCache.store(b.hash, eval);
+    return eval;
+}
 
-            b.undoMove(m, captured);
+// Best exchanges first; the order of equal ones is kept
+static void sortCaptures(const Board& b, MoveList& moves, const EvalParameters& evalParams) {
+    for (auto& m : moves) {
+        m.score = see(b, m, evalParams);
+    }
+    std::stable_sort(moves.begin(), moves.end(), [](const Move& a, const Move& c) {
+        return a.score > c.score;
+    });
+}
+
+// Quiet moves from 'first' on: a piece that is threatened (by a cheaper
+// piece, or attacked and undefended) moves first, moves onto squares the
+// enemy pawns attack come last. Reads the board's attack maps, which the
+// static evaluation of this position may have built already.
+static void sortQuiets(const Board& b, MoveList& moves, int first) {
+    const Board::AttackMaps& maps = b.attackMaps();
+    Color us = b.sideToMove;
+    Color them = (us == WHITE) ? BLACK : WHITE;
+
+    // Squares attacked by an enemy piece cheaper than each of our types
+    Bitboard cheaperAttacks[7];
+    cheaperAttacks[EMPTY] = cheaperAttacks[PAWN] = cheaperAttacks[KING] = 0;
+    cheaperAttacks[KNIGHT] = maps.byType[them][PAWN];
+    cheaperAttacks[BISHOP] = cheaperAttacks[KNIGHT];
+    cheaperAttacks[ROOK] = cheaperAttacks[KNIGHT] | maps.byType[them][KNIGHT] | maps.byType[them][BISHOP];
+    cheaperAttacks[QUEEN] = cheaperAttacks[ROOK] | maps.byType[them][ROOK];
+    Bitboard undefended = maps.byType[them][EMPTY] & ~maps.byType[us][EMPTY];
+
+    for (int i = first; i < moves.size(); i++) {
+        Move& m = moves[i];
+        Bitboard from = squareBB(squareOf(m.fromRow, m.fromCol));
+        Bitboard to = squareBB(squareOf(m.toRow, m.toCol));
+        PieceType type = b.board[m.fromRow][m.fromCol].type;
+        m.score = 0;
+        if ((cheaperAttacks[type] | undefended) & from) m.score += 2;
+        if (type != PAWN && (maps.byType[them][PAWN] & to)) m.score -= 2;
+    }
+    std::stable_sort(moves.begin() + first, moves.end(), [](const Move& a, const Move& c) {
+        return a.score > c.score;
+    });
+}
+
+// Put 'first' (typically the TT move) at the front, keeping the rest in order
+static void orderMoves(MoveList& moves, const Move& first) {
+    if (first.isNull()) return;
+    auto it = std::find(moves.begin(), moves.end(), first);
+    if (it != moves.end()) {
+        std::rotate(moves.begin(), it, it + 1);
+    }
+}
+
+// The TT stores mate scores relative to the node, not the root, so that an
+// entry found via a transposition at another ply still means "mate in n from here"
+static int scoreToTT(int score, int ply) {
+    if (score >= MATE_IN_MAX_PLY) return score + ply;
+    if (score <= -MATE_IN_MAX_PLY) return score - ply;
+    return score;
+}
+
+static int scoreFromTT(int score, int ply) {
+    if (score >= MATE_IN_MAX_PLY) return score - ply;
+    if (score <= -MATE_IN_MAX_PLY) return score + ply;
+    return score;
+}
+
+// Best line at 'ply' becomes 'm' followed by the child's best line
+static void updatePV(SearchContext& ctx, int ply, const Move& m) {
+    Move* line = &ctx.pvTable[ply * MAX_PLY];
+    const Move* childLine = &ctx.pvTable[(ply + 1) * MAX_PLY];
+    int childLength = std::max(ctx.pvLength[ply + 1], ply + 1);
+
+    line[ply] = m;
+    for (int i = ply + 1; i < childLength; i++) {
+        line[i] = childLine[i];
+    }
+    ctx.pvLength[ply] = childLength;
+}
+
+// Extension for a move that has just been made (b is the position after it).
+// Only the largest applicable extension is used, and none once the line is
+// twice as long as the nominal depth, so forcing lines cannot run away.
+static int moveExtension(const Board& b, int ply, const Move& m, bool capture, SearchContext& ctx) {
+    if (ply >= 2 * ctx.rootDepth) return 0;
 
-            alpha = std::max(alpha, value);
-            if (alpha >= beta) break; // beta cutoff
+    int extension = 0;
+    if (b.inCheck(b.sideToMove)) {
+        extension = CHECK_EXTENSION;
+    }
+    if (capture && ply > 0) {
+        const SearchStackEntry& prev = ctx.stack[ply - 1];
+        if (prev.capture && prev.move.toRow == m.toRow && prev.move.toCol == m.toCol) {
+            extension = std::max(extension, RECAPTURE_EXTENSION);
         }
-        return value;
+    }
+    return extension;
+}
+
+// Quiescence search: only captures and queen promotions (plus quiet checks
+// on its first ply, and every evasion when in check) until the position is
+// quiet, so the static eval is never taken in the middle of an exchange
+static int quiescence(Board& b, int ply, int qDepth, int alpha, int beta, SearchContext& ctx) {
+    ctx.pvLength[ply] = ply;
+    ctx.stats.nodes++;
+
+    if (b.isDraw(ply)) {
+        return 0;
+    }
+    if (ply >= MAX_PLY - 1) {
+        return evaluateForSideToMove(b, ctx);
+    }
+
+    bool inCheck = b.inCheck(b.sideToMove);
+    int bestScore = -INF_SCORE;
+    MoveList moves;
+    if (inCheck) {
+        b.generateMoves(EVASIONS, moves);
     }
     else {
-        int value = 999999;
-        for (auto& m : moves) {
-            Piece captured = b.board[m.toRow][m.toCol];
-            b.makeMove(m);
+        // Stand pat: the side to move does not have to capture anything
+        bestScore = evaluateForSideToMove(b, ctx, alpha, beta);
+        if (bestScore >= beta) {
+            return bestScore;
+        }
+        alpha = std::max(alpha, bestScore);
 
-            value = std::min(value, alphaBeta(b, depth - 1, alpha, beta, evalParams));
+        b.generateMoves(CAPTURES, moves);
+        sortCaptures(b, moves, ctx.evalParams);
+        if (qDepth == 0) {
+            b.generateMoves(QUIET_CHECKS, moves);
+        }
+    }
 
-            b.undoMove(m, captured);
+    for (auto& m : moves) {
+        // Captures and checks that lose material cannot raise the stand-pat score
+        if (!inCheck && !seeGE(b, m, 0, ctx.evalParams)) continue;
+
+        bool capture = b.isCapture(m);
+        b.makeMove(m);
+
+        ctx.stack[ply].move = m;
+        ctx.stack[ply].capture = capture;
+        int score = -quiescence(b, ply + 1, qDepth - 1, -beta, -alpha, ctx);
+
+        b.undoMove(m);
 
-            beta = std::min(beta, value);
-            if (beta <= alpha) break; // alpha cutoff
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) break;
+            }
         }
-        return value;
     }
+
+    // In check every legal move was searched, so none means mate
+    if (inCheck && moves.empty()) {
+        return -MATE_SCORE + ply;
+    }
+    return bestScore;
 }
 
-Move findBestMove(Board& b, int depth, const EvalParameters& evalParams) {
-    std::vector<Move> moves = b.generateMoves();
-    Move bestMove;
+static int negamax(Board& b, int depth, int ply, int alpha, int beta, SearchContext& ctx);
 
-    if (moves.empty()) {
-        // No moves
-        return bestMove;
+// Singular extension test for the TT move: search every other move at reduced
+// depth against a window just below the TT score. If none gets there the TT
+// move is singular. Returns the extension, or sets 'multiCut' when even the
+// alternatives beat beta (the node can be cut without searching further).
+static int singularExtension(Board& b, int depth, int ply, int beta, const Move& ttMove,
+    int ttScore, SearchContext& ctx, bool& multiCut)
+{
+    int singularBeta = ttScore - SINGULAR_MARGIN_PER_PLY * depth / ONE_PLY;
+    int singularDepth = (depth - ONE_PLY) / 2;
+
+    ctx.stack[ply].excludedMove = ttMove;
+    int score = negamax(b, singularDepth, ply, singularBeta - 1, singularBeta, ctx);
+    ctx.stack[ply].excludedMove = Move();
+
+    if (score < singularBeta) {
+        return SINGULAR_EXTENSION;
+    }
+    multiCut = (singularBeta >= beta);
+    return 0;
+}
+
+// Negamax with alpha-beta, principal variation search and the transposition table.
+// Scores are relative to the side to move; 'depth' is in fractions of a ply.
+static int negamax(Board& b, int depth, int ply, int alpha, int beta, SearchContext& ctx) {
+    ctx.pvLength[ply] = ply;
+    ctx.stats.nodes++;
+
+    // Draw by repetition or fifty-move rule
+    if (b.isDraw(ply)) {
+        return 0;
+    }
+
+    // If we can force a repetition the node is worth at least a draw
+    if (alpha < 0 && b.hasUpcomingRepetition(ply)) {
+        alpha = 0;
+        if (alpha >= beta) {
+            return alpha;
+        }
+    }
+
+    if (ply >= MAX_PLY - 1) {
+        return evaluateForSideToMove(b, ctx);
+    }
+    if (depth < ONE_PLY) {
+        return quiescence(b, ply, 0, alpha, beta, ctx);
+    }
+
+    bool pvNode = (beta - alpha > 1);
+    const Move excludedMove = ctx.stack[ply].excludedMove;
+
+    // Mate distance pruning: even mating right now cannot beat a shorter mate
+    // already found closer to the root, so shrink the window accordingly
+    alpha = std::max(alpha, -MATE_SCORE + ply);
+    beta = std::min(beta, MATE_SCORE - ply - 1);
+    if (alpha >= beta) {
+        return alpha;
+    }
+
+    // Transposition table: cut off in non-PV nodes, otherwise just use the move.
+    // A verification search with an excluded move must not use or overwrite
+    // the entry of the full node.
+    TTEntry entry;
+    Move ttMove;
+    int ttScore = 0;
+    bool ttHit = excludedMove.isNull() && tt.probe(b.hash, entry);
+    if (ttHit) {
+        ttMove = entry.bestMove;
+        ttScore = scoreFromTT(entry.score, ply);
+        if (!pvNode && entry.depth >= depth) {
+            if (entry.bound == BOUND_EXACT
+                || (entry.bound == BOUND_LOWER && ttScore >= beta)
+                || (entry.bound == BOUND_UPPER && ttScore <= alpha)) {
+                return ttScore;
+            }
+        }
     }
 
-    int bestScore = (b.sideToMove == WHITE) ? -999999 : 999999;
+    // Moves are generated in stages: evasions only when in check, otherwise
+    // the captures (which ProbCut needs on their own) and then the quiets
+    bool inCheck = b.inCheck(b.sideToMove);
+    MoveList moves;
+    if (inCheck) {
+        b.generateMoves(EVASIONS, moves);
+    }
+    else {
+        b.generateMoves(CAPTURES, moves);
+        sortCaptures(b, moves, ctx.evalParams);
+    }
+
+    // ProbCut: if a good capture beats beta by a margin even with a much
+    // shallower null-window search, the full search would almost certainly
+    // fail high as well. Skipped when the TT already says it will not, and
+    // in check, where the static eval means nothing.
+    int probCutBeta = beta + probCutMargin;
+    if (!pvNode && !inCheck && depth >= PROBCUT_MIN_DEPTH && excludedMove.isNull()
+        && !isMateScore(beta)
+        && !(ttHit && entry.depth >= depth - PROBCUT_REDUCTION && ttScore < probCutBeta)) {
+        int staticEval = evaluateForSideToMove(b, ctx);
+        bool tried = false;
+
+        for (auto& m : moves) {
+            bool capture = b.isCapture(m);
+            if (!capture && m.promotion == EMPTY) continue;
+            if (!seeGE(b, m, probCutBeta - staticEval, ctx.evalParams)) continue;
+
+            b.makeMove(m);
+            if (!tried) {
+                tried = true;
+                ctx.stats.probCutTries++;
+            }
+
+            ctx.stack[ply].move = m;
+            ctx.stack[ply].capture = capture;
+            int score = -negamax(b, depth - PROBCUT_REDUCTION, ply + 1, -probCutBeta, -probCutBeta + 1, ctx);
+            b.undoMove(m);
+
+            if (score >= probCutBeta) {
+                ctx.stats.probCutCuts++;
+                tt.store(b.hash, depth - PROBCUT_REDUCTION + ONE_PLY, scoreToTT(score, ply), BOUND_LOWER, m);
+                return score;
+            }
+        }
+    }
+
+    if (!inCheck) {
+        // Near the leaves the order of the quiets hardly matters and building
+        // the attack maps just for it costs more than it saves
+        int quiets = moves.size();
+        b.generateMoves(QUIETS, moves);
+        if (depth >= QUIET_ORDER_MIN_DEPTH) {
+            sortQuiets(b, moves, quiets);
+        }
+    }
+    orderMoves(moves, ttMove);
+
+    int alphaOrig = alpha;
+    int bestScore = -INF_SCORE;
+    Move bestMove;
+    int legalMoves = 0;
 
     for (auto& m : moves) {
-        Piece captured = b.board[m.toRow][m.toCol];
+        if (m == excludedMove) continue;
+
+        // Singular extension candidate: a TT move whose entry is a reliable
+        // lower bound from a search not much shallower than this one. Like
+        // every extension, none past twice the nominal depth.
+        int singular = 0;
+        if (m == ttMove && ply > 0 && ply < 2 * ctx.rootDepth && depth >= SINGULAR_MIN_DEPTH
+            && excludedMove.isNull()
+            && (entry.bound == BOUND_LOWER || entry.bound == BOUND_EXACT)
+            && entry.depth >= depth - 3 * ONE_PLY
+            && !isMateScore(ttScore)) {
+            bool multiCut = false;
+            singular = singularExtension(b, depth, ply, beta, m, ttScore, ctx, multiCut);
+            if (multiCut) {
+                return ttScore - SINGULAR_MARGIN_PER_PLY * depth / ONE_PLY;
+            }
+        }
+
+        bool capture = b.isCapture(m);
         b.makeMove(m);
+        legalMoves++;
+
+        ctx.stack[ply].move = m;
+        ctx.stack[ply].capture = capture;
+        int extension = std::max(singular, moveExtension(b, ply, m, capture, ctx));
+        int newDepth = depth - ONE_PLY + extension;
 
-        int score = alphaBeta(b, depth - 1, -1000000, 1000000, evalParams);
+        int score;
+        if (legalMoves == 1) {
+            score = -negamax(b, newDepth, ply + 1, -beta, -alpha, ctx);
+        }
+        else {
+            // Null-window probe, re-search only if it lands inside the window
+            score = -negamax(b, newDepth, ply + 1, -alpha - 1, -alpha, ctx);
+            if (score > alpha && score < beta) {
+                score = -negamax(b, newDepth, ply + 1, -beta, -alpha, ctx);
+            }
+        }
 
-        b.undoMove(m, captured);
+        b.undoMove(m);
 
-        if (b.sideToMove == WHITE) {
-            if (score > bestScore) {
-                bestScore = score;
-                bestMove = m;
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = m;
+            if (score > alpha) {
+                alpha = score;
+                updatePV(ctx, ply, m);
+                if (alpha >= beta) break; // beta cutoff
             }
         }
+    }
+
+    // No legal moves: checkmate (scored by distance from the root) or stalemate.
+    // With a move excluded the node is not really terminal, so just fail low.
+    if (legalMoves == 0) {
+        if (!excludedMove.isNull()) return alpha;
+        return inCheck ? -MATE_SCORE + ply : 0;
+    }
+
+    if (excludedMove.isNull()) {
+        BoundType bound = (bestScore >= beta) ? BOUND_LOWER
+            : (bestScore > alphaOrig) ? BOUND_EXACT
+            : BOUND_UPPER;
+        tt.store(b.hash, depth, scoreToTT(bestScore, ply), bound, bestMove);
+    }
+
+    return bestScore;
+}
+
+int alphaBeta(Board& b, int depth, int alpha, int beta, const EvalParameters& evalParams) {
+    // Window and result are from White's point of view, as before
+    prepareEvalCache(evalParams);
+    SearchContext ctx(evalParams);
+    ctx.rootDepth = depth;
+    int score = (b.sideToMove == WHITE)
+        ? negamax(b, depth * ONE_PLY, 0, alpha, beta, ctx)
+        : -negamax(b, depth * ONE_PLY, 0, -beta, -alpha, ctx);
+    lastStats = ctx.stats;
+    return score;
+}
+
+static bool isExcluded(const Move& m, const std::vector<SearchLine>& lines) {
+    for (const auto& line : lines) {
+        if (line.move == m) return true;
+    }
+    return false;
+}
+
+// Full-window search of the root moves that are not already in 'found'.
+// Returns false when every root move has been excluded.
+static bool searchRootLine(Board& b, int depth, const std::vector<Move>& rootMoves,
+    const std::vector<SearchLine>& found, SearchContext& ctx, SearchLine& line)
+{
+    int alpha = -INF_SCORE;
+    int beta = INF_SCORE;
+    int bestScore = -INF_SCORE;
+    bool searched = false;
+
+    ctx.pvLength[0] = 0;
+
+    for (const auto& m : rootMoves) {
+        if (isExcluded(m, found)) continue;
+
+        bool capture = b.isCapture(m);
+        b.makeMove(m);
+
+        ctx.stack[0].move = m;
+        ctx.stack[0].capture = capture;
+        int newDepth = (depth - 1) * ONE_PLY + moveExtension(b, 0, m, capture, ctx);
+
+        int score;
+        if (!searched) {
+            score = -negamax(b, newDepth, 1, -beta, -alpha, ctx);
+        }
         else {
-            if (score < bestScore) {
-                bestScore = score;
-                bestMove = m;
+            score = -negamax(b, newDepth, 1, -alpha - 1, -alpha, ctx);
+            if (score > alpha) {
+                score = -negamax(b, newDepth, 1, -beta, -alpha, ctx);
             }
         }
+
+        b.undoMove(m);
+
+        if (!searched || score > bestScore) {
+            bestScore = score;
+            alpha = std::max(alpha, score);
+            updatePV(ctx, 0, m);
+        }
+        searched = true;
+    }
+
+    if (!searched) return false;
+
+    line.move = ctx.pvTable[0];
+    line.score = (b.sideToMove == WHITE) ? bestScore : -bestScore;
+    line.pv.assign(ctx.pvTable.begin(), ctx.pvTable.begin() + ctx.pvLength[0]);
+    return true;
+}
+
+std::vector<SearchLine> searchMultiPV(Board& b, int depth, int multiPV, const EvalParameters& evalParams) {
+    std::vector<SearchLine> lines;
+    std::vector<Move> rootMoves = b.generateLegalMoves();
+    if (rootMoves.empty() || depth < 1 || multiPV < 1) {
+        return lines;
+    }
+    multiPV = std::min(multiPV, static_cast<int>(rootMoves.size()));
+
+    prepareEvalCache(evalParams);
+    SearchContext ctx(evalParams);
+
+    // Iterative deepening; at each depth the k-th line is the best root move
+    // once the first k-1 lines are excluded
+    for (int d = 1; d <= depth; d++) {
+        std::vector<SearchLine> current;
+        ctx.rootDepth = d;
+        for (int k = 0; k < multiPV; k++) {
+            SearchLine line;
+            if (!searchRootLine(b, d, rootMoves, current, ctx, line)) break;
+            current.push_back(line);
+        }
+        lines = current;
+        lastStats = ctx.stats;
+
+        // Next iteration tries the previous ranking first
+        std::vector<Move> ordered;
+        ordered.reserve(rootMoves.size());
+        for (const auto& line : lines) {
+            ordered.push_back(line.move);
+        }
+        for (const auto& m : rootMoves) {
+            if (!isExcluded(m, lines)) ordered.push_back(m);
+        }
+        rootMoves.swap(ordered);
+
+        // A mate within 'd' plies was found by a full-width search, so deeper
+        // iterations cannot change it: stop once every line is a proven mate
+        bool allMatesProven = true;
+        for (const auto& line : lines) {
+            if (!isMateScore(line.score) || MATE_SCORE - std::abs(line.score) > d) {
+                allMatesProven = false;
+                break;
+            }
+        }
+        if (allMatesProven) break;
+    }
+
+    return lines;
+}
+
+const SearchStats& lastSearchStats() {
+    return lastStats;
+}
+
+void setProbCutMargin(int margin) {
+    probCutMargin = margin;
+}
+
+void clearTranspositionTable() {
+    tt.clear();
+    evalCache.clear();
+}
+
+void setEvalCacheSize(size_t sizeMB) {
+    evalCache.resize(sizeMB);
+}
+
+Move findBestMove(Board& b, int depth, const EvalParameters& evalParams) {
+    std::vector<SearchLine> lines = searchMultiPV(b, depth, 1, evalParams);
+    if (lines.empty()) {
+        // No moves
+        return Move();
     }
-    return bestMove;
+    return lines[0].move;
 }
@@ -4,10 +4,52 @@
 #include "Evaluation.h" // we need evaluateBoard, EvalParameters
 #include "Board.h"
 
+// Search limits and mate scores. A mate found 'n' plies from the root
+// scores MATE_SCORE - n (from the winner's point of view).
+const int MAX_PLY = 128;
+const int MATE_SCORE = 100000;
+const int MATE_IN_MAX_PLY = MATE_SCORE - MAX_PLY;
+
+inline bool isMateScore(int score) {
+    return score >= MATE_IN_MAX_PLY || score <= -MATE_IN_MAX_PLY;
+}
+
+// One ranked root line produced by the MultiPV search
+struct SearchLine {
+    Move move;            // Root move of this line
+    int score;            // From White's point of view, like evaluateBoard
+    std::vector<Move> pv; // Principal variation, starting with 'move'
+};
+
+// Counters from the most recent findBestMove / searchMultiPV call
+struct SearchStats {
+    uint64_t nodes;
+    uint64_t probCutTries; // Nodes where ProbCut searched at least one capture
+    uint64_t probCutCuts;  // ...and was able to cut the node
+    uint64_t evalCacheProbes; // Static evaluations asked for
+    uint64_t evalCacheHits;   // ...and found in the eval cache
+    EvalTierStats evalTiers;  // Classical evaluations and the tiers they skipped
+};
+
+const SearchStats& lastSearchStats();
+
+// ProbCut margin over beta, in centipawns (tuned with the bench harness)
+void setProbCutMargin(int margin);
+
+// Forget all stored positions and evaluations (e.g. between bench positions)
+void clearTranspositionTable();
+
+// Size of the static eval cache (EvalCache.h) in megabytes; clears it
+void setEvalCacheSize(size_t sizeMB);
+
 // Alpha-Beta search
 int alphaBeta(Board& b, int depth, int alpha, int beta, const EvalParameters& evalParams);
 
 // Returns the best move
 Move findBestMove(Board& b, int depth, const EvalParameters& evalParams);
 
+// MultiPV analysis: the best 'multiPV' root moves with exact scores and PVs,
+// ranked best first for the side to move
+std::vector<SearchLine> searchMultiPV(Board& b, int depth, int multiPV, const EvalParameters& evalParams);
+
 #endif // MINIMAX_H
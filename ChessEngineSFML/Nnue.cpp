@@ -0,0 +1,437 @@
+#include "Nnue.h"
+#include "Board.h"
+#include "Cpu.h"
+#include "NnueKernels.h"
+
+#include <algorithm> // for std::copy
+#include <cstring>   // for std::memcmp
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#if CPU_X86_64
+#include <immintrin.h>
+#endif
+
+// --------------------------------------------------
+// Features
+// --------------------------------------------------
+
+// Buckets by the king's (own-side) square: the back two ranks are split
+// into queenside and kingside, the rest by rank and half as well
+static constexpr int KING_BUCKET_OF_RANK[8] = { 0, 2, 4, 6, 6, 6, 6, 6 };
+
+static int orient(Color perspective, int sq) {
+    return (perspective == WHITE) ? sq : sq ^ 56;
+}
+
+int nnueKingBucket(Color perspective, int kingSq) {
+    int sq = orient(perspective, kingSq);
+    return KING_BUCKET_OF_RANK[rowOf(sq)] + (colOf(sq) >= 4 ? 1 : 0);
+}
+
+int nnueFeature(Color perspective, int kingSq, Piece p, int sq) {
+    int piece = (p.color == perspective ? 0 : 6) + (p.type - PAWN);
+    return (nnueKingBucket(perspective, kingSq) * 12 + piece) * 64 + orient(perspective, sq);
+}
+
+// --------------------------------------------------
+// Network
+// --------------------------------------------------
+static NnueNetwork network;
+static NnueDenseLayers dense;          // network's dense layers in kernel layout
+static uint32_t networkGeneration = 0; // 0: no network
+static bool nnueOn = false;
+
+static const char NNUE_MAGIC[4] = { 'N', 'N', 'U', 'E' };
+
+static void resizeNetwork(NnueNetwork& net) {
+    net.ftBiases.resize(NNUE_L1);
+    net.ftWeights.resize(static_cast<size_t>(NNUE_INPUTS) * NNUE_L1);
+    net.l2Biases.resize(NNUE_L2);
+    net.l2Weights.resize(NNUE_L2 * 2 * NNUE_L1);
+    net.l3Biases.resize(NNUE_L3);
+    net.l3Weights.resize(NNUE_L3 * NNUE_L2);
+    net.outWeights.resize(NNUE_L3);
+}
+
+template <typename T>
+static bool readArray(std::istream& in, std::vector<T>& v) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(v.data()), v.size() * sizeof(T)));
+}
+
+template <typename T>
+static void writeArray(std::ostream& out, const std::vector<T>& v) {
+    out.write(reinterpret_cast<const char*>(v.data()), v.size() * sizeof(T));
+}
+
+bool readNetwork(const std::string& path, NnueNetwork& net) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cout << "Cannot open network file " << path << "\n";
+        return false;
+    }
+
+    char magic[4];
+    uint32_t header[5];
+    if (!in.read(magic, 4) || !in.read(reinterpret_cast<char*>(header), sizeof(header))
+        || std::memcmp(magic, NNUE_MAGIC, 4) != 0) {
+        std::cout << path << " is not a network file\n";
+        return false;
+    }
+    if (header[0] != NNUE_FILE_VERSION) {
+        std::cout << path << " has network format version " << header[0]
+            << ", this build reads version " << NNUE_FILE_VERSION << "\n";
+        return false;
+    }
+    if (header[1] != NNUE_KING_BUCKETS || header[2] != NNUE_L1 || header[3] != NNUE_L2 || header[4] != NNUE_L3) {
+        std::cout << path << " has a different architecture ("
+            << header[1] << " buckets, " << header[2] << "x" << header[3] << "x" << header[4] << ")\n";
+        return false;
+    }
+
+    resizeNetwork(net);
+    bool ok = readArray(in, net.ftBiases) && readArray(in, net.ftWeights)
+        && readArray(in, net.l2Biases) && readArray(in, net.l2Weights)
+        && readArray(in, net.l3Biases) && readArray(in, net.l3Weights)
+        && in.read(reinterpret_cast<char*>(&net.outBias), sizeof(net.outBias))
+        && readArray(in, net.outWeights);
+    if (!ok || in.peek() != std::ifstream::traits_type::eof()) {
+        std::cout << path << " is truncated or has trailing data\n";
+        return false;
+    }
+    return true;
+}
+
+bool writeNetwork(const std::string& path, const NnueNetwork& net) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        std::cout << "Cannot create network file " << path << "\n";
+        return false;
+    }
+
+    uint32_t header[5] = { NNUE_FILE_VERSION, NNUE_KING_BUCKETS, NNUE_L1, NNUE_L2, NNUE_L3 };
+    out.write(NNUE_MAGIC, 4);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    writeArray(out, net.ftBiases);
+    writeArray(out, net.ftWeights);
+    writeArray(out, net.l2Biases);
+    writeArray(out, net.l2Weights);
+    writeArray(out, net.l3Biases);
+    writeArray(out, net.l3Weights);
+    out.write(reinterpret_cast<const char*>(&net.outBias), sizeof(net.outBias));
+    writeArray(out, net.outWeights);
+    if (!out) {
+        std::cout << "Writing " << path << " failed\n";
+        return false;
+    }
+    return true;
+}
+
+bool loadNetwork(const std::string& path) {
+    NnueNetwork loaded;
+    if (!readNetwork(path, loaded)) {
+        return false;
+    }
+    setNetwork(std::move(loaded));
+    return true;
+}
+
+void setNetwork(NnueNetwork net) {
+    network = std::move(net);
+    packDenseLayers(network, dense);
+    networkGeneration++;
+}
+
+bool networkLoaded() {
+    return networkGeneration != 0;
+}
+
+uint32_t nnueNetworkGeneration() {
+    return networkGeneration;
+}
+
+bool setUseNnue(bool on) {
+    nnueOn = on && networkLoaded();
+    return nnueOn == on;
+}
+
+bool useNnue() {
+    return nnueOn;
+}
+
+// --------------------------------------------------
+// Accumulator kernels
+// --------------------------------------------------
+// dst = src + the 'added' weight rows - the 'removed' ones (dst may be src).
+// Each path keeps a tile of the accumulator in registers while all the rows
+// are applied, so the accumulator is read and written once per update.
+typedef void (*UpdateKernel)(int16_t* dst, const int16_t* src, const int16_t* weights,
+    const int* added, int addedCount, const int* removed, int removedCount);
+
+static void updateRowsScalar(int16_t* dst, const int16_t* src, const int16_t* weights,
+    const int* added, int addedCount, const int* removed, int removedCount) {
+    for (int i = 0; i < NNUE_L1; i++) {
+        int16_t v = src[i];
+        for (int k = 0; k < addedCount; k++) v += weights[added[k] * NNUE_L1 + i];
+        for (int k = 0; k < removedCount; k++) v -= weights[removed[k] * NNUE_L1 + i];
+        dst[i] = v;
+    }
+}
+
+#if CPU_X86_64
+// SSE2 is part of x86-64, so this needs no check
+static void updateRowsSse2(int16_t* dst, const int16_t* src, const int16_t* weights,
+    const int* added, int addedCount, const int* removed, int removedCount) {
+    constexpr int LANES = 8;
+    constexpr int TILE = 8; // registers per tile
+    for (int base = 0; base < NNUE_L1; base += LANES * TILE) {
+        __m128i acc[TILE];
+        for (int j = 0; j < TILE; j++) {
+            acc[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + base + j * LANES));
+        }
+        for (int k = 0; k < addedCount; k++) {
+            const int16_t* row = weights + added[k] * NNUE_L1 + base;
+            for (int j = 0; j < TILE; j++) {
+                acc[j] = _mm_add_epi16(acc[j], _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j * LANES)));
+            }
+        }
+        for (int k = 0; k < removedCount; k++) {
+            const int16_t* row = weights + removed[k] * NNUE_L1 + base;
+            for (int j = 0; j < TILE; j++) {
+                acc[j] = _mm_sub_epi16(acc[j], _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j * LANES)));
+            }
+        }
+        for (int j = 0; j < TILE; j++) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + base + j * LANES), acc[j]);
+        }
+    }
+}
+
+TARGET_AVX2 static void updateRowsAvx2(int16_t* dst, const int16_t* src, const int16_t* weights,
+    const int* added, int addedCount, const int* removed, int removedCount) {
+    constexpr int LANES = 16;
+    constexpr int TILE = 8;
+    for (int base = 0; base < NNUE_L1; base += LANES * TILE) {
+        __m256i acc[TILE];
+        for (int j = 0; j < TILE; j++) {
+            acc[j] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + base + j * LANES));
+        }
+        for (int k = 0; k < addedCount; k++) {
+            const int16_t* row = weights + added[k] * NNUE_L1 + base;
+            for (int j = 0; j < TILE; j++) {
+                acc[j] = _mm256_add_epi16(acc[j], _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + j * LANES)));
+            }
+        }
+        for (int k = 0; k < removedCount; k++) {
+            const int16_t* row = weights + removed[k] * NNUE_L1 + base;
+            for (int j = 0; j < TILE; j++) {
+                acc[j] = _mm256_sub_epi16(acc[j], _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + j * LANES)));
+            }
+        }
+        for (int j = 0; j < TILE; j++) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + base + j * LANES), acc[j]);
+        }
+    }
+}
+#endif
+
+static UpdateKernel updateRows = updateRowsScalar;
+static NnuePath currentPath = NNUE_PORTABLE;
+
+bool setNnuePath(NnuePath path) {
+    if (!nnuePathSupported(path)) {
+        return false;
+    }
+    currentPath = path;
+    updateRows = updateRowsScalar;
+#if CPU_X86_64
+    if (path == NNUE_AVX2 || path == NNUE_AVX512_VNNI) updateRows = updateRowsAvx2;
+    else if (path == NNUE_SSE41) updateRows = updateRowsSse2;
+#endif
+    return true;
+}
+
+NnuePath nnuePath() {
+    return currentPath;
+}
+
+void selectNnueKernels(bool useExtensions) {
+    int path = useExtensions ? NNUE_PATH_COUNT - 1 : NNUE_PORTABLE;
+    while (!setNnuePath(static_cast<NnuePath>(path))) {
+        path--;
+    }
+}
+
+bool nnueKernelSelfTest() {
+    std::mt19937 rng(7);
+    std::vector<int16_t> weights(64 * NNUE_L1);
+    for (auto& w : weights) w = static_cast<int16_t>(static_cast<int>(rng() % 512) - 256);
+
+    struct Kernel {
+        const char* name;
+        UpdateKernel fn;
+    };
+    std::vector<Kernel> kernels;
+#if CPU_X86_64
+    kernels.push_back({ "sse2", updateRowsSse2 });
+    if (cpuFeatures().avx2) kernels.push_back({ "avx2", updateRowsAvx2 });
+#endif
+
+    bool ok = true;
+    alignas(64) int16_t src[NNUE_L1], expected[NNUE_L1], actual[NNUE_L1];
+    for (const Kernel& k : kernels) {
+        int mismatches = 0;
+        for (int round = 0; round < 200; round++) {
+            for (auto& v : src) v = static_cast<int16_t>(static_cast<int>(rng() % 4096) - 2048);
+            int added[32], removed[32];
+            int addedCount = rng() % 33;
+            int removedCount = rng() % 33;
+            for (int i = 0; i < addedCount; i++) added[i] = rng() % 64;
+            for (int i = 0; i < removedCount; i++) removed[i] = rng() % 64;
+            updateRowsScalar(expected, src, weights.data(), added, addedCount, removed, removedCount);
+            k.fn(actual, src, weights.data(), added, addedCount, removed, removedCount);
+            if (std::memcmp(expected, actual, sizeof(actual)) != 0) mismatches++;
+        }
+        std::cout << "NNUE " << k.name << " update: " << (mismatches ? "FAILED" : "ok") << "\n";
+        ok = ok && mismatches == 0;
+    }
+    return nnueDenseSelfTest() && ok;
+}
+
+// --------------------------------------------------
+// Accumulator maintenance
+// --------------------------------------------------
+
+// Finny table: per perspective and king bucket, the accumulator of the last
+// position refreshed there and the pieces it contains. A refresh only adds
+// and removes the pieces that differ, usually a handful. One table per
+// thread, since entries are updated in place.
+struct FinnyEntry {
+    alignas(64) int16_t values[NNUE_L1];
+    Bitboard pieces[2][7];
+    uint32_t generation;
+};
+
+static thread_local FinnyEntry finnyTable[2][NNUE_KING_BUCKETS];
+
+static int kingSquare(const Board& b, Color c) {
+    return lsb(b.pieceBB[c][KING]);
+}
+
+// Rebuild one perspective of 'acc' for the position on the board
+static void refreshAccumulator(const Board& b, Color perspective, NnueAccumulator& acc) {
+    int kingSq = kingSquare(b, perspective);
+    FinnyEntry& entry = finnyTable[perspective][nnueKingBucket(perspective, kingSq)];
+    if (entry.generation != networkGeneration) {
+        std::copy(network.ftBiases.begin(), network.ftBiases.end(), entry.values);
+        for (auto& bb : entry.pieces) {
+            for (auto& x : bb) x = 0;
+        }
+        entry.generation = networkGeneration;
+    }
+
+    // At most 32 pieces can differ in each direction
+    int added[32], removed[32];
+    int addedCount = 0, removedCount = 0;
+    for (int color = 0; color < 2; color++) {
+        for (int t = PAWN; t <= KING; t++) {
+            Piece p(static_cast<PieceType>(t), static_cast<Color>(color));
+            Bitboard now = b.pieceBB[color][t];
+            Bitboard then = entry.pieces[color][t];
+            for (Bitboard x = now & ~then; x; ) {
+                added[addedCount++] = nnueFeature(perspective, kingSq, p, popLsb(x));
+            }
+            for (Bitboard x = then & ~now; x; ) {
+                removed[removedCount++] = nnueFeature(perspective, kingSq, p, popLsb(x));
+            }
+            entry.pieces[color][t] = now;
+        }
+    }
+
+    updateRows(entry.values, entry.values, network.ftWeights.data(), added, addedCount, removed, removedCount);
+    std::copy(entry.values, entry.values + NNUE_L1, acc.values[perspective]);
+    acc.computedFor[perspective] = networkGeneration;
+}
+
+// Bring one perspective of the current position's accumulator up to date
+static void updateAccumulator(const Board& b, Color perspective) {
+    size_t ply = b.history.size();
+    std::vector<NnueAccumulator>& stack = b.accumulators;
+    if (stack[ply].computedFor[perspective] == networkGeneration) {
+        return;
+    }
+
+    // Walk back to the closest computed accumulator. A move of this side's
+    // king into another bucket changes every feature: refresh instead.
+    size_t start = ply;
+    while (start > 0 && stack[start].computedFor[perspective] != networkGeneration) {
+        const DirtyPieces& dirty = b.history[start - 1].dirty;
+        if (dirty.piece[0].type == KING && dirty.piece[0].color == perspective
+            && nnueKingBucket(perspective, dirty.from[0]) != nnueKingBucket(perspective, dirty.to[0])) {
+            refreshAccumulator(b, perspective, stack[ply]);
+            return;
+        }
+        start--;
+    }
+    if (stack[start].computedFor[perspective] != networkGeneration) {
+        refreshAccumulator(b, perspective, stack[ply]);
+        return;
+    }
+
+    // Every position in between has the current king bucket, so the
+    // current king square gives the right feature indices for all of them
+    int kingSq = kingSquare(b, perspective);
+    for (size_t i = start; i < ply; i++) {
+        const DirtyPieces& dirty = b.history[i].dirty;
+        int added[3], removed[3];
+        int addedCount = 0, removedCount = 0;
+        for (int k = 0; k < dirty.count; k++) {
+            if (dirty.from[k] >= 0) removed[removedCount++] = nnueFeature(perspective, kingSq, dirty.piece[k], dirty.from[k]);
+            if (dirty.to[k] >= 0) added[addedCount++] = nnueFeature(perspective, kingSq, dirty.piece[k], dirty.to[k]);
+        }
+        updateRows(stack[i + 1].values[perspective], stack[i].values[perspective], network.ftWeights.data(),
+            added, addedCount, removed, removedCount);
+        stack[i + 1].computedFor[perspective] = networkGeneration;
+    }
+}
+
+// --------------------------------------------------
+// Forward pass
+// --------------------------------------------------
+// The dense layers run on the current path's kernels (NnueKernels.cpp)
+static int propagate(const NnueAccumulator& acc, Color us) {
+    const int16_t* ours = acc.values[us];
+    const int16_t* theirs = acc.values[us == WHITE ? BLACK : WHITE];
+    int32_t output = nnueForward(currentPath, dense, ours, theirs);
+    return output * NNUE_OUTPUT_SCALE / (NNUE_ACTIVATION_MAX << NNUE_WEIGHT_SHIFT);
+}
+
+int nnueEvaluate(const Board& b) {
+    size_t ply = b.history.size();
+    if (b.accumulators.size() <= ply) {
+        b.accumulators.resize(ply + 1);
+    }
+    updateAccumulator(b, WHITE);
+    updateAccumulator(b, BLACK);
+    return propagate(b.accumulators[ply], b.sideToMove);
+}
+
+int nnueEvaluateFull(const Board& b) {
+    NnueAccumulator acc;
+    for (int perspective = 0; perspective < 2; perspective++) {
+        Color c = static_cast<Color>(perspective);
+        int kingSq = kingSquare(b, c);
+        std::copy(network.ftBiases.begin(), network.ftBiases.end(), acc.values[c]);
+        for (int color = 0; color < 2; color++) {
+            for (int t = PAWN; t <= KING; t++) {
+                Piece p(static_cast<PieceType>(t), static_cast<Color>(color));
+                for (Bitboard x = b.pieceBB[color][t]; x; ) {
+                    int feature = nnueFeature(c, kingSq, p, popLsb(x));
+                    updateRowsScalar(acc.values[c], acc.values[c], network.ftWeights.data(), &feature, 1, nullptr, 0);
+                }
+            }
+        }
+    }
+    return propagate(acc, b.sideToMove);
+}
@@ -0,0 +1,130 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "ChessTypes.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Board;
+
+// --------------------------------------------------
+// NNUE evaluation
+// --------------------------------------------------
+// An efficiently updatable neural network. The input layer has one feature
+// per (king bucket, piece, square) as seen from each side ("HalfKA" with
+// king buckets): a position has about 30 active features, and a move changes
+// two to four of them. So the first layer's output, the accumulator, is not
+// recomputed: makeMove records which pieces changed, and the evaluation adds
+// and subtracts the weight rows of those features from the parent's
+// accumulator. Only a king move into another bucket changes every feature of
+// its side; that side is then rebuilt from a per-bucket cache (the "finny
+// table") by applying just the pieces that differ from the cached position.
+//
+//   2 x NNUE_L1 accumulator (int16, side to move first)
+//   -> clipped ReLU to 0..127 (uint8)
+//   -> NNUE_L2 (int8 weights, int32 sums) -> clipped ReLU
+//   -> NNUE_L3 -> clipped ReLU -> 1 output, scaled to centipawns
+//
+// Quantization: an activation of 1.0 is 127, a hidden-layer weight of 1.0 is
+// 64 (2^NNUE_WEIGHT_SHIFT), so each hidden sum is shifted right by 6 to get
+// back to the activation scale. An output of 1.0 is NNUE_OUTPUT_SCALE
+// centipawns.
+
+constexpr int NNUE_KING_BUCKETS = 8;
+constexpr int NNUE_INPUTS = NNUE_KING_BUCKETS * 12 * 64;
+constexpr int NNUE_L1 = 256;
+constexpr int NNUE_L2 = 16;
+constexpr int NNUE_L3 = 32;
+constexpr int NNUE_ACTIVATION_MAX = 127;
+constexpr int NNUE_WEIGHT_SHIFT = 6;
+constexpr int NNUE_OUTPUT_SCALE = 400;
+
+// Bumped whenever the file layout or the architecture above changes
+constexpr uint32_t NNUE_FILE_VERSION = 1;
+
+// Network parameters, quantized, in the order of the file. Dense weights are
+// row-major: weights[out * inputs + in].
+struct NnueNetwork {
+    std::vector<int16_t> ftBiases;  // NNUE_L1
+    std::vector<int16_t> ftWeights; // NNUE_INPUTS rows of NNUE_L1
+    std::vector<int32_t> l2Biases;  // NNUE_L2
+    std::vector<int8_t> l2Weights;  // NNUE_L2 x 2 * NNUE_L1
+    std::vector<int32_t> l3Biases;  // NNUE_L3
+    std::vector<int8_t> l3Weights;  // NNUE_L3 x NNUE_L2
+    int32_t outBias;
+    std::vector<int8_t> outWeights; // NNUE_L3
+};
+
+// Piece changes of one move, recorded by makeMove for the accumulator update
+// (a move changes at most three pieces: a capturing promotion)
+struct DirtyPieces {
+    Piece piece[3];
+    int8_t from[3]; // -1 when the piece appears (promotion)
+    int8_t to[3];   // -1 when the piece disappears (capture, promotion)
+    int8_t count;
+};
+
+// First-layer output for one position, from each side's point of view.
+// 'computedFor' is the generation of the network the values were computed
+// with (0: not computed), so loading another network invalidates them all.
+struct NnueAccumulator {
+    alignas(64) int16_t values[2][NNUE_L1]; // [perspective]
+    uint32_t computedFor[2] = { 0, 0 };
+};
+
+// Feature geometry: squares are mirrored top to bottom for Black, so both
+// sides see their own pieces from rank 1
+int nnueKingBucket(Color perspective, int kingSq);
+int nnueFeature(Color perspective, int kingSq, Piece p, int sq);
+
+// Network files: a header (magic, NNUE_FILE_VERSION, layer sizes) followed by
+// the arrays of NnueNetwork in order, little-endian. Both functions print
+// why they failed.
+bool readNetwork(const std::string& path, NnueNetwork& net);
+bool writeNetwork(const std::string& path, const NnueNetwork& net);
+
+// Make 'path' the network the engine evaluates with
+bool loadNetwork(const std::string& path);
+bool networkLoaded();
+
+// The same for a network built in memory (trainer, benchmarks)
+void setNetwork(NnueNetwork net);
+
+// Changes whenever another network is set (0: none yet), so caches of
+// NNUE scores can tell they are stale
+uint32_t nnueNetworkGeneration();
+
+// The search evaluates with NNUE instead of evaluateBoard while this is on
+// (only possible once a network is loaded)
+bool setUseNnue(bool on);
+bool useNnue();
+
+// Centipawns from the side to move's point of view. Brings the accumulators
+// of the current position up to date from the closest computed ancestor.
+int nnueEvaluate(const Board& b);
+
+// The same from a freshly built accumulator (for checking the incremental one)
+int nnueEvaluateFull(const Board& b);
+
+// Kernel sets for the layers after the accumulator, slowest first. The
+// accumulator updates follow along: AVX2 for the two AVX paths, SSE2 for
+// SSE4.1, scalar for portable.
+enum NnuePath { NNUE_PORTABLE, NNUE_SSE41, NNUE_AVX2, NNUE_AVX512_VNNI, NNUE_PATH_COUNT };
+
+bool nnuePathSupported(NnuePath path);
+const char* nnuePathName(NnuePath path);
+
+// Returns false (and changes nothing) if the CPU lacks the path
+bool setNnuePath(NnuePath path);
+NnuePath nnuePath();
+
+// Called by selectCpuPaths: the best supported path, or portable
+void selectNnueKernels(bool useExtensions);
+
+// Compares every available accumulator and dense-layer kernel with the
+// portable one on random data (part of runCpuSelfTest)
+bool nnueKernelSelfTest();
+
+#endif // NNUE_H
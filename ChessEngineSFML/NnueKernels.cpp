@@ -0,0 +1,423 @@
+#include "NnueKernels.h"
+#include "Cpu.h"
+
+#include <algorithm> // for std::min, std::max
+#include <cstring>   // for std::memcpy
+#include <iostream>
+#include <random>
+
+#if CPU_X86_64
+#include <immintrin.h>
+#endif
+
+static constexpr int IN1 = 2 * NNUE_L1;   // first dense layer inputs
+static constexpr int MAX_OUTPUTS = 32;    // widest dense layer
+
+// --------------------------------------------------
+// Layout and path queries
+// --------------------------------------------------
+static void packLayer(const std::vector<int8_t>& weights, int inputs, int outputs, std::vector<int8_t>& packed) {
+    packed.resize(weights.size());
+    for (int group = 0; group < inputs / 4; group++) {
+        for (int o = 0; o < outputs; o++) {
+            for (int k = 0; k < 4; k++) {
+                packed[(group * outputs + o) * 4 + k] = weights[o * inputs + group * 4 + k];
+            }
+        }
+    }
+}
+
+void packDenseLayers(const NnueNetwork& net, NnueDenseLayers& dense) {
+    packLayer(net.l2Weights, IN1, NNUE_L2, dense.l2Packed);
+    packLayer(net.l3Weights, NNUE_L2, NNUE_L3, dense.l3Packed);
+    dense.l2Biases = net.l2Biases;
+    dense.l3Biases = net.l3Biases;
+    dense.outWeights = net.outWeights;
+    dense.outBias = net.outBias;
+}
+
+bool nnuePathSupported(NnuePath path) {
+    const CpuFeatures& f = cpuFeatures();
+    switch (path) {
+    case NNUE_PORTABLE:    return true;
+    case NNUE_SSE41:       return CPU_X86_64 && f.sse41;
+    case NNUE_AVX2:        return CPU_X86_64 && f.avx2;
+    case NNUE_AVX512_VNNI: return CPU_X86_64 && f.avx512 && f.avx512Vnni;
+    default:               return false;
+    }
+}
+
+const char* nnuePathName(NnuePath path) {
+    switch (path) {
+    case NNUE_PORTABLE:    return "portable";
+    case NNUE_SSE41:       return "sse4.1";
+    case NNUE_AVX2:        return "avx2";
+    case NNUE_AVX512_VNNI: return "avx512vnni";
+    default:               return "?";
+    }
+}
+
+// --------------------------------------------------
+// Portable path
+// --------------------------------------------------
+static inline uint8_t clipActivation(int x) {
+    return static_cast<uint8_t>(std::min(std::max(x, 0), NNUE_ACTIVATION_MAX));
+}
+
+static void clipAccumulatorScalar(const int16_t* ours, const int16_t* theirs, uint8_t* out) {
+    for (int i = 0; i < NNUE_L1; i++) {
+        out[i] = clipActivation(ours[i]);
+        out[NNUE_L1 + i] = clipActivation(theirs[i]);
+    }
+}
+
+// Indices of the groups of four inputs that are not all zero
+static int nonZeroGroupsScalar(const uint8_t* in, int inCount, uint16_t* groups) {
+    int count = 0;
+    for (int g = 0; g < inCount / 4; g++) {
+        uint32_t word;
+        std::memcpy(&word, in + g * 4, 4);
+        if (word) groups[count++] = static_cast<uint16_t>(g);
+    }
+    return count;
+}
+
+template <int OUTPUTS>
+static void affineScalar(const uint8_t* in, const uint16_t* groups, int groupCount,
+    const int8_t* packed, const int32_t* biases, int32_t* out) {
+    for (int o = 0; o < OUTPUTS; o++) out[o] = biases[o];
+    for (int n = 0; n < groupCount; n++) {
+        int g = groups[n];
+        const int8_t* w = packed + g * OUTPUTS * 4;
+        const uint8_t* x = in + g * 4;
+        for (int o = 0; o < OUTPUTS; o++) {
+            out[o] += w[o * 4] * x[0] + w[o * 4 + 1] * x[1] + w[o * 4 + 2] * x[2] + w[o * 4 + 3] * x[3];
+        }
+    }
+}
+
+// Shared by every path: the hidden layers are too narrow to be worth vectors
+static void clipSums(const int32_t* sums, int count, uint8_t* out) {
+    for (int i = 0; i < count; i++) {
+        out[i] = clipActivation(sums[i] >> NNUE_WEIGHT_SHIFT);
+    }
+}
+
+static int32_t outputLayer(const NnueDenseLayers& dense, const uint8_t* in) {
+    int32_t output = dense.outBias;
+    for (int i = 0; i < NNUE_L3; i++) {
+        output += dense.outWeights[i] * in[i];
+    }
+    return output;
+}
+
+static int32_t forwardPortable(const NnueDenseLayers& dense, const int16_t* ours, const int16_t* theirs) {
+    alignas(64) uint8_t input[IN1];
+    alignas(64) uint8_t hidden1[NNUE_L2];
+    alignas(64) uint8_t hidden2[NNUE_L3];
+    alignas(64) int32_t sums[MAX_OUTPUTS];
+    uint16_t groups[IN1 / 4];
+
+    clipAccumulatorScalar(ours, theirs, input);
+    int count = nonZeroGroupsScalar(input, IN1, groups);
+    affineScalar<NNUE_L2>(input, groups, count, dense.l2Packed.data(), dense.l2Biases.data(), sums);
+    clipSums(sums, NNUE_L2, hidden1);
+
+    count = nonZeroGroupsScalar(hidden1, NNUE_L2, groups);
+    affineScalar<NNUE_L3>(hidden1, groups, count, dense.l3Packed.data(), dense.l3Biases.data(), sums);
+    clipSums(sums, NNUE_L3, hidden2);
+    return outputLayer(dense, hidden2);
+}
+
+#if CPU_X86_64
+static inline int32_t loadGroup(const uint8_t* in, int g) {
+    int32_t word;
+    std::memcpy(&word, in + g * 4, 4);
+    return word;
+}
+
+// For each 8-bit mask, the indices of its set bits and how many there are
+struct GroupIndices {
+    uint16_t index[256][8];
+    uint8_t count[256];
+
+    constexpr GroupIndices() : index(), count() {
+        for (int mask = 0; mask < 256; mask++) {
+            for (int bit = 0; bit < 8; bit++) {
+                if (mask & (1 << bit)) index[mask][count[mask]++] = static_cast<uint16_t>(bit);
+            }
+        }
+    }
+};
+
+static constexpr GroupIndices groupIndices;
+
+// Appends base + the index of every set bit of an 8-bit 'mask'. Always
+// stores eight entries, so 'groups' needs room for eight past the end; a
+// loop over the bits would mispredict on nearly every mask.
+static inline int appendGroups(unsigned mask, int base, uint16_t* groups, int count) {
+    __m128i indices = _mm_loadu_si128(reinterpret_cast<const __m128i*>(groupIndices.index[mask]));
+    indices = _mm_add_epi16(indices, _mm_set1_epi16(static_cast<int16_t>(base)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(groups + count), indices);
+    return count + groupIndices.count[mask];
+}
+
+// --------------------------------------------------
+// SSE4.1 path: PMADDUBSW + PMADDWD, 4 outputs per register
+// --------------------------------------------------
+// Saturating int16 -> int8 packing clamps to 127 at the top and a max with
+// zero does the bottom: the clipped ReLU in two instructions
+TARGET_SSE41 static void clipAccumulatorSse41(const int16_t* ours, const int16_t* theirs, uint8_t* out) {
+    const __m128i zero = _mm_setzero_si128();
+    for (int half = 0; half < 2; half++) {
+        const int16_t* acc = half ? theirs : ours;
+        for (int i = 0; i < NNUE_L1; i += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i + 8));
+            __m128i packed = _mm_max_epi8(_mm_packs_epi16(a, b), zero);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + half * NNUE_L1 + i), packed);
+        }
+    }
+}
+
+// Activations are at most 127, so a group read as int32 is never negative
+TARGET_SSE41 static int nonZeroGroupsSse41(const uint8_t* in, int inCount, uint16_t* groups) {
+    const __m128i zero = _mm_setzero_si128();
+    int count = 0;
+    for (int i = 0; i < inCount; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        unsigned mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(x, zero)));
+        count = appendGroups(mask, i / 4, groups, count);
+    }
+    return count;
+}
+
+template <int OUTPUTS>
+TARGET_SSE41 static void affineSse41(const uint8_t* in, const uint16_t* groups, int groupCount,
+    const int8_t* packed, const int32_t* biases, int32_t* out) {
+    const __m128i ones = _mm_set1_epi16(1);
+    constexpr int regs = OUTPUTS / 4;
+    __m128i acc[regs];
+    for (int j = 0; j < regs; j++) {
+        acc[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(biases + j * 4));
+    }
+    for (int n = 0; n < groupCount; n++) {
+        int g = groups[n];
+        __m128i x = _mm_set1_epi32(loadGroup(in, g));
+        const int8_t* w = packed + g * OUTPUTS * 4;
+        for (int j = 0; j < regs; j++) {
+            __m128i products = _mm_maddubs_epi16(x, _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + j * 16)));
+            acc[j] = _mm_add_epi32(acc[j], _mm_madd_epi16(products, ones));
+        }
+    }
+    for (int j = 0; j < regs; j++) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j * 4), acc[j]);
+    }
+}
+
+TARGET_SSE41 static int32_t forwardSse41(const NnueDenseLayers& dense, const int16_t* ours, const int16_t* theirs) {
+    alignas(64) uint8_t input[IN1];
+    alignas(64) uint8_t hidden1[NNUE_L2];
+    alignas(64) uint8_t hidden2[NNUE_L3];
+    alignas(64) int32_t sums[MAX_OUTPUTS];
+    uint16_t groups[IN1 / 4 + 8]; // appendGroups writes past the end
+
+    clipAccumulatorSse41(ours, theirs, input);
+    int count = nonZeroGroupsSse41(input, IN1, groups);
+    affineSse41<NNUE_L2>(input, groups, count, dense.l2Packed.data(), dense.l2Biases.data(), sums);
+    clipSums(sums, NNUE_L2, hidden1);
+
+    count = nonZeroGroupsSse41(hidden1, NNUE_L2, groups);
+    affineSse41<NNUE_L3>(hidden1, groups, count, dense.l3Packed.data(), dense.l3Biases.data(), sums);
+    clipSums(sums, NNUE_L3, hidden2);
+    return outputLayer(dense, hidden2);
+}
+
+// --------------------------------------------------
+// AVX2 path: the same on 256-bit registers, 8 outputs per register
+// --------------------------------------------------
+// The 256-bit pack works within 128-bit lanes; the permute puts the four
+// 64-bit pieces back in order
+TARGET_AVX2 static inline void clipAccumulatorAvx2(const int16_t* ours, const int16_t* theirs, uint8_t* out) {
+    const __m256i zero = _mm256_setzero_si256();
+    for (int half = 0; half < 2; half++) {
+        const int16_t* acc = half ? theirs : ours;
+        for (int i = 0; i < NNUE_L1; i += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc + i + 16));
+            __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(a, b), zero);
+            packed = _mm256_permute4x64_epi64(packed, 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + half * NNUE_L1 + i), packed);
+        }
+    }
+}
+
+TARGET_AVX2 static int nonZeroGroupsAvx2(const uint8_t* in, int inCount, uint16_t* groups) {
+    int count = 0;
+    int i = 0;
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 32 <= inCount; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(x, zero)));
+        count = appendGroups(mask, i / 4, groups, count);
+    }
+    for (; i < inCount; i += 4) {
+        if (loadGroup(in, i / 4)) groups[count++] = static_cast<uint16_t>(i / 4);
+    }
+    return count;
+}
+
+template <int OUTPUTS>
+TARGET_AVX2 static void affineAvx2(const uint8_t* in, const uint16_t* groups, int groupCount,
+    const int8_t* packed, const int32_t* biases, int32_t* out) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    constexpr int regs = OUTPUTS / 8;
+    __m256i acc[regs];
+    for (int j = 0; j < regs; j++) {
+        acc[j] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(biases + j * 8));
+    }
+    for (int n = 0; n < groupCount; n++) {
+        int g = groups[n];
+        __m256i x = _mm256_set1_epi32(loadGroup(in, g));
+        const int8_t* w = packed + g * OUTPUTS * 4;
+        for (int j = 0; j < regs; j++) {
+            __m256i products = _mm256_maddubs_epi16(x, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + j * 32)));
+            acc[j] = _mm256_add_epi32(acc[j], _mm256_madd_epi16(products, ones));
+        }
+    }
+    for (int j = 0; j < regs; j++) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j * 8), acc[j]);
+    }
+}
+
+TARGET_AVX2 static int32_t forwardAvx2(const NnueDenseLayers& dense, const int16_t* ours, const int16_t* theirs) {
+    alignas(64) uint8_t input[IN1];
+    alignas(64) uint8_t hidden1[NNUE_L2];
+    alignas(64) uint8_t hidden2[NNUE_L3];
+    alignas(64) int32_t sums[MAX_OUTPUTS];
+    uint16_t groups[IN1 / 4 + 8];
+
+    clipAccumulatorAvx2(ours, theirs, input);
+    int count = nonZeroGroupsAvx2(input, IN1, groups);
+    affineAvx2<NNUE_L2>(input, groups, count, dense.l2Packed.data(), dense.l2Biases.data(), sums);
+    clipSums(sums, NNUE_L2, hidden1);
+
+    count = nonZeroGroupsAvx2(hidden1, NNUE_L2, groups);
+    affineAvx2<NNUE_L3>(hidden1, groups, count, dense.l3Packed.data(), dense.l3Biases.data(), sums);
+    clipSums(sums, NNUE_L3, hidden2);
+    return outputLayer(dense, hidden2);
+}
+
+// --------------------------------------------------
+// AVX-512 VNNI path: VPDPBUSD does a group's multiply-add for 16 outputs
+// in one instruction
+// --------------------------------------------------
+TARGET_AVX512_VNNI static int nonZeroGroupsAvx512(const uint8_t* in, int inCount, uint16_t* groups) {
+    int count = 0;
+    int i = 0;
+    const __m512i zero = _mm512_setzero_si512();
+    for (; i + 64 <= inCount; i += 64) {
+        __m512i x = _mm512_loadu_si512(in + i);
+        unsigned mask = _mm512_cmpgt_epi32_mask(x, zero);
+        count = appendGroups(mask & 0xFF, i / 4, groups, count);
+        count = appendGroups(mask >> 8, i / 4 + 8, groups, count);
+    }
+    for (; i < inCount; i += 4) {
+        if (loadGroup(in, i / 4)) groups[count++] = static_cast<uint16_t>(i / 4);
+    }
+    return count;
+}
+
+template <int OUTPUTS>
+TARGET_AVX512_VNNI static void affineAvx512Vnni(const uint8_t* in, const uint16_t* groups, int groupCount,
+    const int8_t* packed, const int32_t* biases, int32_t* out) {
+    constexpr int regs = OUTPUTS / 16;
+    __m512i acc[regs];
+    for (int j = 0; j < regs; j++) {
+        acc[j] = _mm512_loadu_si512(biases + j * 16);
+    }
+    for (int n = 0; n < groupCount; n++) {
+        int g = groups[n];
+        __m512i x = _mm512_set1_epi32(loadGroup(in, g));
+        const int8_t* w = packed + g * OUTPUTS * 4;
+        for (int j = 0; j < regs; j++) {
+            acc[j] = _mm512_dpbusd_epi32(acc[j], x, _mm512_loadu_si512(w + j * 64));
+        }
+    }
+    for (int j = 0; j < regs; j++) {
+        _mm512_storeu_si512(out + j * 16, acc[j]);
+    }
+}
+
+TARGET_AVX512_VNNI static int32_t forwardAvx512Vnni(const NnueDenseLayers& dense, const int16_t* ours, const int16_t* theirs) {
+    alignas(64) uint8_t input[IN1];
+    alignas(64) uint8_t hidden1[NNUE_L2];
+    alignas(64) uint8_t hidden2[NNUE_L3];
+    alignas(64) int32_t sums[MAX_OUTPUTS];
+    uint16_t groups[IN1 / 4 + 8];
+
+    clipAccumulatorAvx2(ours, theirs, input);
+    int count = nonZeroGroupsAvx512(input, IN1, groups);
+    affineAvx512Vnni<NNUE_L2>(input, groups, count, dense.l2Packed.data(), dense.l2Biases.data(), sums);
+    clipSums(sums, NNUE_L2, hidden1);
+
+    count = nonZeroGroupsAvx2(hidden1, NNUE_L2, groups);
+    affineAvx512Vnni<NNUE_L3>(hidden1, groups, count, dense.l3Packed.data(), dense.l3Biases.data(), sums);
+    clipSums(sums, NNUE_L3, hidden2);
+    return outputLayer(dense, hidden2);
+}
+#endif
+
+// --------------------------------------------------
+// Dispatch and self-test
+// --------------------------------------------------
+int32_t nnueForward(NnuePath path, const NnueDenseLayers& dense, const int16_t* ours, const int16_t* theirs) {
+    switch (path) {
+#if CPU_X86_64
+    case NNUE_AVX512_VNNI: return forwardAvx512Vnni(dense, ours, theirs);
+    case NNUE_AVX2:        return forwardAvx2(dense, ours, theirs);
+    case NNUE_SSE41:       return forwardSse41(dense, ours, theirs);
+#endif
+    default:               return forwardPortable(dense, ours, theirs);
+    }
+}
+
+bool nnueDenseSelfTest() {
+    std::mt19937 rng(11);
+    NnueNetwork net;
+    net.l2Weights.resize(NNUE_L2 * IN1);
+    net.l3Weights.resize(NNUE_L3 * NNUE_L2);
+    net.outWeights.resize(NNUE_L3);
+    net.l2Biases.resize(NNUE_L2);
+    net.l3Biases.resize(NNUE_L3);
+    // Full int8 range, to catch any saturation in the int16 products
+    for (auto& w : net.l2Weights) w = static_cast<int8_t>(rng() % 256 - 128);
+    for (auto& w : net.l3Weights) w = static_cast<int8_t>(rng() % 256 - 128);
+    for (auto& w : net.outWeights) w = static_cast<int8_t>(rng() % 256 - 128);
+    for (auto& b : net.l2Biases) b = static_cast<int32_t>(rng() % 20000) - 5000;
+    for (auto& b : net.l3Biases) b = static_cast<int32_t>(rng() % 20000) - 5000;
+    net.outBias = 1234;
+
+    NnueDenseLayers dense;
+    packDenseLayers(net, dense);
+
+    bool ok = true;
+    alignas(64) int16_t ours[NNUE_L1], theirs[NNUE_L1];
+    for (int p = NNUE_SSE41; p < NNUE_PATH_COUNT; p++) {
+        NnuePath path = static_cast<NnuePath>(p);
+        if (!nnuePathSupported(path)) continue;
+        int mismatches = 0;
+        for (int round = 0; round < 500; round++) {
+            // Mostly negative (clipped to zero) like real accumulators, some
+            // above the clip
+            for (int i = 0; i < NNUE_L1; i++) {
+                ours[i] = static_cast<int16_t>(static_cast<int>(rng() % 400) - 250);
+                theirs[i] = static_cast<int16_t>(static_cast<int>(rng() % 400) - 250);
+            }
+            if (nnueForward(path, dense, ours, theirs) != forwardPortable(dense, ours, theirs)) mismatches++;
+        }
+        std::cout << "NNUE " << nnuePathName(path) << " layers: " << (mismatches ? "FAILED" : "ok") << "\n";
+        ok = ok && mismatches == 0;
+    }
+    return ok;
+}
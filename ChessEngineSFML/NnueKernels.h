@@ -0,0 +1,44 @@
+#ifndef NNUEKERNELS_H
+#define NNUEKERNELS_H
+
+#include "Nnue.h"
+
+#include <cstdint>
+#include <vector>
+
+// --------------------------------------------------
+// Quantized NNUE layers after the accumulator
+// --------------------------------------------------
+// Each hidden layer is an int8 matrix times a uint8 activation vector with
+// int32 sums. The kernels walk the input four bytes at a time, and only the
+// groups of four that are not all zero: after the clipped ReLU most of the
+// first layer's 512 inputs are 0, so most of its columns are skipped. One
+// group is one dot-product step of the instruction sets (VPDPBUSD with
+// AVX-512 VNNI, PMADDUBSW + PMADDWD with AVX2 and SSE4.1), so the weights
+// are repacked at load time with the four weights of a group for each
+// output next to each other:
+//
+//   packed[(group * outputs + o) * 4 + k] = weights[o][group * 4 + k]
+
+// The dense layers of a network in kernel layout
+struct NnueDenseLayers {
+    std::vector<int8_t> l2Packed;
+    std::vector<int32_t> l2Biases;
+    std::vector<int8_t> l3Packed;
+    std::vector<int32_t> l3Biases;
+    std::vector<int8_t> outWeights;
+    int32_t outBias;
+};
+
+void packDenseLayers(const NnueNetwork& net, NnueDenseLayers& dense);
+
+// Network output before scaling to centipawns, from the two halves of an
+// accumulator (side to move first), computed with the given path's kernels.
+// The path must be supported by the CPU.
+int32_t nnueForward(NnuePath path, const NnueDenseLayers& dense, const int16_t* ours, const int16_t* theirs);
+
+// Compares every supported path with the portable one on random layers and
+// accumulators (called by nnueKernelSelfTest)
+bool nnueDenseSelfTest();
+
+#endif // NNUEKERNELS_H
@@ -0,0 +1,149 @@
+#include "Pawns.h"
+
+#include <algorithm> // for std::clamp, std::fill
+
+// --------------------------------------------------
+// Terms
+// --------------------------------------------------
+// Indexed by relative rank (0 = the side's own first rank). The piece-square
+// tables already push pawns forward, so these stay small.
+static constexpr Score PASSED_RANK[8] = {
+    S(0, 0), S(2, 8), S(4, 12), S(6, 22), S(22, 40), S(50, 90), S(90, 150), S(0, 0)
+};
+static constexpr Score CONNECTED_RANK[8] = {
+    S(0, 0), S(3, 1), S(5, 3), S(8, 6), S(16, 12), S(28, 24), S(48, 44), S(0, 0)
+};
+static constexpr Score ISOLATED = S(-6, -14);
+static constexpr Score DOUBLED = S(-10, -24);
+static constexpr Score BACKWARD = S(-8, -12);
+
+// Nearest own pawn in front of the king, per file of the king and its
+// neighbours, by relative rank; [0] is a file with no such pawn
+static constexpr Score SHELTER_RANK[8] = {
+    S(-24, 0), S(0, 0), S(18, 0), S(10, 0), S(2, 0), S(0, 0), S(0, 0), S(0, 0)
+};
+
+template <Color Us>
+static constexpr int relativeRank(int sq) {
+    return (Us == WHITE) ? rowOf(sq) : 7 - rowOf(sq);
+}
+
+// Structure terms of one color, from its own point of view. Each pawn class
+// is a whole bitboard at once: fills give the files and spans, shifts the
+// neighbours.
+template <Color Us>
+static Score evaluatePawns(const Board& b, PawnEntry* e) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    constexpr Direction UP = (Us == WHITE) ? NORTH : SOUTH;
+    constexpr Direction DOWN = (Us == WHITE) ? SOUTH : NORTH;
+
+    Bitboard ours = b.pieceBB[Us][PAWN];
+    Bitboard theirs = b.pieceBB[Them][PAWN];
+    Bitboard ourAttacks = pawnAttacksBB<Us>(ours);
+    Bitboard theirAttacks = pawnAttacksBB<Them>(theirs);
+
+    e->attacks[Us] = ourAttacks;
+
+    // Squares the pawns attack now or could attack by advancing
+    Bitboard attackSpan = ourAttacks | frontSpans<Us>(ourAttacks);
+
+    // Neither an enemy pawn on the same or a neighbouring file ahead of it,
+    // nor an own pawn in front of it on its file
+    Bitboard blocked = frontSpans<Them>(theirs) | frontSpans<Them>(theirAttacks) | theirAttacks;
+    Bitboard passed = ours & ~blocked & ~frontSpans<Them>(ours);
+    e->passed[Us] = passed;
+
+    Bitboard neighbourFiles = fileFill(shift<EAST>(ours) | shift<WEST>(ours));
+    Bitboard isolated = ours & ~neighbourFiles;
+
+    // Every own pawn but the rearmost on its file
+    Bitboard doubled = ours & frontSpans<Us>(ours);
+
+    // Not isolated, but no own pawn level with or behind it on a neighbouring
+    // file (so none can ever guard its stop square), which an enemy pawn attacks
+    Bitboard stops = shift<UP>(ours);
+    Bitboard backward = ours & neighbourFiles & shift<DOWN>(stops & theirAttacks & ~attackSpan);
+
+    // Defended by a pawn, or side by side with one
+    Bitboard connected = ours & (ourAttacks | shift<EAST>(ours) | shift<WEST>(ours));
+
+    Score score = ISOLATED * popCount(isolated) + DOUBLED * popCount(doubled)
+        + BACKWARD * popCount(backward);
+    for (Bitboard x = passed; x; ) {
+        score += PASSED_RANK[relativeRank<Us>(popLsb(x))];
+    }
+    for (Bitboard x = connected; x; ) {
+        score += CONNECTED_RANK[relativeRank<Us>(popLsb(x))];
+    }
+    return score;
+}
+
+template <Color Us>
+static Score shelterFor(Bitboard ours, int kingSq) {
+    // Own pawns on the king's rank or in front of it
+    Bitboard ahead = ours & ((Us == WHITE) ? ~0ULL << (8 * rowOf(kingSq)) : ~0ULL >> (8 * (7 - rowOf(kingSq))));
+
+    Score score = SCORE_ZERO;
+    int center = std::clamp(colOf(kingSq), 1, 6);
+    for (int file = center - 1; file <= center + 1; file++) {
+        Bitboard pawns = ahead & (FILE_A_BB << file);
+        if (!pawns) {
+            score += SHELTER_RANK[0];
+            continue;
+        }
+        int nearest = (Us == WHITE) ? lsb(pawns) : msb(pawns);
+        score += SHELTER_RANK[relativeRank<Us>(nearest)];
+    }
+    return score;
+}
+
+Score PawnEntry::kingShelter(const Board& b, Color c, int kingSq) {
+    if (shelterSquare[c] != kingSq) {
+        shelterSquare[c] = static_cast<int8_t>(kingSq);
+        shelter[c] = (c == WHITE) ? shelterFor<WHITE>(b.pieceBB[WHITE][PAWN], kingSq)
+            : shelterFor<BLACK>(b.pieceBB[BLACK][PAWN], kingSq);
+    }
+    return shelter[c];
+}
+
+// --------------------------------------------------
+// Table
+// --------------------------------------------------
+PawnTable::PawnTable(size_t sizeMB)
+    : mask(0) {
+    size_t entries = (sizeMB * 1024 * 1024) / sizeof(PawnEntry);
+    size_t count = 1;
+    while (count * 2 <= entries) {
+        count *= 2;
+    }
+    table.resize(count);
+    mask = count - 1;
+    clear();
+}
+
+// An empty slot holds key 0 with the terms of a board without pawns, which
+// is exactly the entry key 0 stands for, so it needs no valid flag
+void PawnTable::clear() {
+    PawnEntry empty = {};
+    empty.shelterSquare[WHITE] = empty.shelterSquare[BLACK] = -1;
+    std::fill(table.begin(), table.end(), empty);
+}
+
+PawnEntry* PawnTable::probe(const Board& b) {
+    PawnEntry* e = &table[b.pawnKey & mask];
+    probes++;
+    if (e->key == b.pawnKey) {
+        hits++;
+        return e;
+    }
+
+    e->key = b.pawnKey;
+    e->score = evaluatePawns<WHITE>(b, e) - evaluatePawns<BLACK>(b, e);
+    e->shelterSquare[WHITE] = e->shelterSquare[BLACK] = -1;
+    return e;
+}
+
+PawnTable& pawnTable() {
+    static thread_local PawnTable table;
+    return table;
+}
@@ -0,0 +1,54 @@
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include "Board.h"
+
+#include <cstdint>
+#include <vector>
+
+// --------------------------------------------------
+// Pawn structure
+// --------------------------------------------------
+// Everything evaluation knows about the pawns that depends on nothing but
+// the pawns: passed, isolated, doubled, backward and connected pawns,
+// computed a whole color at a time with bitboard fills. Pawn structure
+// changes far less often than the rest of the position, so the results are
+// kept in a hash table keyed by Board::pawnKey and most leaves only read
+// them.
+struct PawnEntry {
+    uint64_t key;
+    Score score;            // structure terms, White minus Black
+    Bitboard passed[2];     // passed pawns of each color
+    Bitboard attacks[2];    // squares the pawns of each color attack
+
+    // King shelter also depends on the king's square; it is computed for
+    // the first king square a probe asks about and again when the king moves
+    int8_t shelterSquare[2];
+    Score shelter[2];
+
+    // The shelter score of 'c' for its king on 'kingSq', from c's point of view
+    Score kingShelter(const Board& b, Color c, int kingSq);
+};
+
+class PawnTable {
+public:
+    explicit PawnTable(size_t sizeMB = 4);
+
+    void clear();
+
+    // The entry for the pawns of 'b', computed first if it is not in the table
+    PawnEntry* probe(const Board& b);
+
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+
+private:
+    std::vector<PawnEntry> table;
+    size_t mask;
+};
+
+// The calling thread's pawn table (each search thread gets its own, so the
+// entries need no locking)
+PawnTable& pawnTable();
+
+#endif // PAWNS_H
@@ -0,0 +1,24 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+#include "ChessTypes.h"
+#include "Score.h"
+
+// --------------------------------------------------
+// Piece-square tables
+// --------------------------------------------------
+// Positional bonus of a piece on a square, for the middlegame and for the
+// endgame; evaluation blends the two by game phase. Material is not included
+// (piece values are EvalParameters, which training changes). Entries are from
+// White's point of view: Black's are the mirrored squares with the sign
+// flipped, so a position's score is the plain sum over its pieces, which is
+// what Board keeps up to date move by move.
+struct alignas(64) PieceSquareTables {
+    Score psq[2][7][64]; // [color][piece type][square]
+
+    constexpr PieceSquareTables();
+};
+
+extern const PieceSquareTables psqt;
+
+#endif // PSQT_H
@@ -0,0 +1,69 @@
+#ifndef SCORE_H
+#define SCORE_H
+
+#include <cstdint>
+
+// --------------------------------------------------
+// Packed middlegame/endgame scores
+// --------------------------------------------------
+// Every evaluation term has a middlegame and an endgame weight. A Score holds
+// both in one 32-bit integer, the endgame half in the upper 16 bits and the
+// middlegame half in the lower 16, so adding or subtracting two terms (or
+// scaling one by a count) is a single integer operation on both halves, and
+// arrays of Scores add up as plain int vectors. The halves are only taken
+// apart once, when the total is blended by game phase (taper).
+//
+// The lower half borrows from the upper one when it is negative; mgValue and
+// egValue undo that, so each half can range over int16_t.
+enum Score : int32_t { SCORE_ZERO = 0 };
+
+constexpr Score makeScore(int mg, int eg) {
+    return static_cast<Score>(static_cast<int32_t>(static_cast<uint32_t>(eg) << 16) + mg);
+}
+
+// Shorthand for tables of scores
+constexpr Score S(int mg, int eg) { return makeScore(mg, eg); }
+
+constexpr int mgValue(Score s) {
+    return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(s)));
+}
+
+constexpr int egValue(Score s) {
+    return static_cast<int16_t>(static_cast<uint16_t>((static_cast<uint32_t>(s) + 0x8000) >> 16));
+}
+
+constexpr Score operator+(Score a, Score b) { return static_cast<Score>(int32_t(a) + int32_t(b)); }
+constexpr Score operator-(Score a, Score b) { return static_cast<Score>(int32_t(a) - int32_t(b)); }
+constexpr Score operator-(Score s) { return static_cast<Score>(-int32_t(s)); }
+constexpr Score operator*(Score s, int k) { return static_cast<Score>(int32_t(s) * k); }
+constexpr Score operator*(int k, Score s) { return s * k; }
+constexpr Score& operator+=(Score& a, Score b) { return a = a + b; }
+constexpr Score& operator-=(Score& a, Score b) { return a = a - b; }
+
+// Game phase from the non-pawn material on the board: PHASE_MAX with all of
+// it (pure middlegame), 0 with none left (pure endgame)
+constexpr int PHASE_MAX = 24;
+constexpr int PHASE_WEIGHTS[7] = { 0, 0, 1, 1, 2, 4, 0 }; // by piece type
+
+// The single step from a Score to a centipawn value: the two halves blended
+// by phase (promotions can push the phase past the starting material, so it
+// is capped)
+constexpr int taper(Score s, int phase) {
+    phase = (phase < PHASE_MAX) ? phase : PHASE_MAX;
+    return (mgValue(s) * phase + egValue(s) * (PHASE_MAX - phase)) / PHASE_MAX;
+}
+
+// Endgame scale factors: the endgame half counts scale / SCALE_NORMAL of
+// its value (drawish endings get less than SCALE_NORMAL, dead draws 0)
+constexpr int SCALE_NORMAL = 64;
+
+constexpr int taper(Score s, int phase, int scale) {
+    phase = (phase < PHASE_MAX) ? phase : PHASE_MAX;
+    return (mgValue(s) * phase + egValue(s) * scale / SCALE_NORMAL * (PHASE_MAX - phase)) / PHASE_MAX;
+}
+
+static_assert(mgValue(S(-5, 7)) == -5 && egValue(S(-5, 7)) == 7, "packing");
+static_assert(mgValue(S(3, -4) - S(10, -20)) == -7 && egValue(S(3, -4) - S(10, -20)) == 16, "subtraction");
+static_assert(egValue(S(-100, -200) * 3) == -600, "scaling");
+
+#endif // SCORE_H
@@ -0,0 +1,137 @@
+#include "See.h"
+
+// Least valuable piece of 'side' among 'attackers'; sets 'type' to its kind
+static int leastValuableAttacker(const Board& b, Bitboard attackers, Color side, PieceType& type) {
+    for (int t = PAWN; t <= KING; t++) {
+        Bitboard pieces = attackers & b.pieceBB[side][t];
+        if (pieces) {
+            type = static_cast<PieceType>(t);
+            return lsb(pieces);
+        }
+    }
+    type = EMPTY;
+    return -1;
+}
+
+// Sliders that were hidden behind the piece that just left 'occupied'
+static Bitboard revealedAttackers(const Board& b, int to, Bitboard occupied, PieceType moved) {
+    Bitboard revealed = 0;
+    if (moved == PAWN || moved == BISHOP || moved == QUEEN) {
+        revealed |= bishopAttacks(to, occupied)
+            & (b.pieceBB[WHITE][BISHOP] | b.pieceBB[BLACK][BISHOP]
+                | b.pieceBB[WHITE][QUEEN] | b.pieceBB[BLACK][QUEEN]);
+    }
+    if (moved == ROOK || moved == QUEEN) {
+        revealed |= rookAttacks(to, occupied)
+            & (b.pieceBB[WHITE][ROOK] | b.pieceBB[BLACK][ROOK]
+                | b.pieceBB[WHITE][QUEEN] | b.pieceBB[BLACK][QUEEN]);
+    }
+    return revealed;
+}
+
+// What 'm' takes, and the value left standing on the target square afterwards
+static int capturedValue(const Board& b, const Move& m, const EvalParameters& evalParams) {
+    int value = (m.kind == EN_PASSANT) ? pieceValue(PAWN, evalParams)
+        : pieceValue(b.board[m.toRow][m.toCol].type, evalParams);
+    if (m.promotion != EMPTY) {
+        value += pieceValue(m.promotion, evalParams) - pieceValue(PAWN, evalParams);
+    }
+    return value;
+}
+
+static int landingValue(const Board& b, const Move& m, const EvalParameters& evalParams) {
+    PieceType landing = (m.promotion != EMPTY) ? m.promotion : b.board[m.fromRow][m.fromCol].type;
+    return pieceValue(landing, evalParams);
+}
+
+// Occupancy once 'm' has been played (the en passant victim is not on 'to')
+static Bitboard occupancyAfter(const Board& b, const Move& m) {
+    int from = squareOf(m.fromRow, m.fromCol);
+    Bitboard occupied = (b.colorBB[WHITE] | b.colorBB[BLACK]) ^ squareBB(from);
+    if (m.kind == EN_PASSANT) {
+        occupied ^= squareBB(squareOf(m.fromRow, m.toCol));
+    }
+    return occupied;
+}
+
+int see(const Board& b, const Move& m, const EvalParameters& evalParams) {
+    if (m.kind == CASTLING) return 0;
+
+    int to = squareOf(m.toRow, m.toCol);
+    Color side = b.board[m.fromRow][m.fromCol].color;
+
+    // Swap list: gain[d] is the score for the side making capture d if the
+    // exchange stopped right after it
+    int gain[32];
+    int d = 0;
+    gain[0] = capturedValue(b, m, evalParams);
+    int victim = landingValue(b, m, evalParams);
+
+    Bitboard occupied = occupancyAfter(b, m);
+    Bitboard attackers = b.attackersTo(to, occupied) & occupied;
+
+    while (d < 31) {
+        side = (side == WHITE) ? BLACK : WHITE;
+        PieceType type;
+        int from = leastValuableAttacker(b, attackers & b.colorBB[side], side, type);
+        if (from < 0) break;
+
+        // A king can only take last, when nothing defends the square any more
+        if (type == KING && (attackers & b.colorBB[side == WHITE ? BLACK : WHITE])) break;
+
+        d++;
+        gain[d] = victim - gain[d - 1];
+        victim = pieceValue(type, evalParams);
+
+        occupied ^= squareBB(from);
+        attackers = (attackers | revealedAttackers(b, to, occupied, type)) & occupied;
+    }
+
+    // Each side stops capturing where that is better for it
+    while (d > 0) {
+        gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+        d--;
+    }
+    return gain[0];
+}
+
+bool seeGE(const Board& b, const Move& m, int threshold, const EvalParameters& evalParams) {
+    if (m.kind == CASTLING) return 0 >= threshold;
+
+    // 'balance' is the score relative to the threshold with the opponent to
+    // recapture: if even losing the capturing piece keeps us above it, we are done
+    int balance = capturedValue(b, m, evalParams) - threshold;
+    if (balance < 0) return false;
+
+    balance = landingValue(b, m, evalParams) - balance;
+    if (balance <= 0) return true;
+
+    int to = squareOf(m.toRow, m.toCol);
+    Color side = b.board[m.fromRow][m.fromCol].color;
+    Bitboard occupied = occupancyAfter(b, m);
+    Bitboard attackers = b.attackersTo(to, occupied) & occupied;
+
+    // 'result' flips with every capture: it is what the exchange means for us
+    // if the side that just captured can stop there
+    bool result = true;
+    while (true) {
+        side = (side == WHITE) ? BLACK : WHITE;
+        PieceType type;
+        int from = leastValuableAttacker(b, attackers & b.colorBB[side], side, type);
+        if (from < 0) break;
+
+        // A king capture only stands if the square is no longer defended
+        if (type == KING) {
+            bool defended = (attackers & b.colorBB[side == WHITE ? BLACK : WHITE]) != 0;
+            return defended ? result : !result;
+        }
+
+        result = !result;
+        balance = pieceValue(type, evalParams) - balance;
+        if (balance < (result ? 1 : 0)) break;
+
+        occupied ^= squareBB(from);
+        attackers = (attackers | revealedAttackers(b, to, occupied, type)) & occupied;
+    }
+    return result;
+}
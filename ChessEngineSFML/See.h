@@ -0,0 +1,23 @@
+#ifndef SEE_H
+#define SEE_H
+
+#include "Board.h"
+#include "Evaluation.h" // we need EvalParameters
+
+// --------------------------------------------------
+// Static Exchange Evaluation
+// --------------------------------------------------
+// Material outcome of the capture sequence started by 'm' on its target
+// square, both sides always recapturing with their least valuable attacker
+// and free to stop when going on would lose material. Sliders behind the
+// capturing pieces (x-rays) join in as the pieces in front leave; pins are
+// ignored. Quiet moves are scored as the exchange that follows on their
+// target square.
+
+// Exact exchange value, in the piece values of 'evalParams'
+int see(const Board& b, const Move& m, const EvalParameters& evalParams);
+
+// see(b, m, evalParams) >= threshold, stopping as soon as the answer is known
+bool seeGE(const Board& b, const Move& m, int threshold, const EvalParameters& evalParams);
+
+#endif // SEE_H
@@ -0,0 +1,477 @@
+#include "Trainer.h"
+#include "Nnue.h"
+#include "NnueKernels.h"
+#include "TrainingData.h"
+
+#include <algorithm> // for std::min, std::max, std::clamp
+#include <chrono>
+#include <cmath>
+#include <cstdio>    // for std::remove, std::rename
+#include <cstring>   // for std::memcmp
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// --------------------------------------------------
+// Parameter layout
+// --------------------------------------------------
+// All parameters live in one float vector, in the order of NnueNetwork, so
+// gradients, optimizer moments and checkpoints are flat vectors too
+static constexpr size_t FT_W = 0;
+static constexpr size_t FT_B = FT_W + static_cast<size_t>(NNUE_INPUTS) * NNUE_L1;
+static constexpr size_t L2_W = FT_B + NNUE_L1;
+static constexpr size_t L2_B = L2_W + NNUE_L2 * 2 * NNUE_L1;
+static constexpr size_t L3_W = L2_B + NNUE_L2;
+static constexpr size_t L3_B = L3_W + NNUE_L3 * NNUE_L2;
+static constexpr size_t OUT_W = L3_B + NNUE_L3;
+static constexpr size_t OUT_B = OUT_W + NNUE_L3;
+static constexpr size_t PARAM_COUNT = OUT_B + 1;
+
+// Largest weights the quantized file can hold: int8 at 64 per 1.0 for the
+// dense layers. Feature weights are int16 at 127 per 1.0; the limit keeps
+// a full accumulator (32 pieces plus the bias) inside int16.
+static constexpr float HIDDEN_WEIGHT_LIMIT = 127.0f / (1 << NNUE_WEIGHT_SHIFT);
+static constexpr float FT_WEIGHT_LIMIT = 7.5f;
+
+// The network output is in units of NNUE_OUTPUT_SCALE centipawns
+static constexpr float OUTPUT_TO_WDL = NNUE_OUTPUT_SCALE / WDL_SCALE;
+
+// One tensor of the layout, as AdamW treats it
+struct Tensor {
+    size_t offset;
+    size_t size;
+    bool decay;  // weight decay applies to weights, not biases
+    float limit; // clamp after each step (0: none)
+};
+
+static const Tensor TENSORS[] = {
+    { FT_W, FT_B - FT_W, true, FT_WEIGHT_LIMIT },
+    { FT_B, L2_W - FT_B, false, FT_WEIGHT_LIMIT },
+    { L2_W, L2_B - L2_W, true, HIDDEN_WEIGHT_LIMIT },
+    { L2_B, L3_W - L2_B, false, 0.0f },
+    { L3_W, L3_B - L3_W, true, HIDDEN_WEIGHT_LIMIT },
+    { L3_B, OUT_W - L3_B, false, 0.0f },
+    { OUT_W, OUT_B - OUT_W, true, HIDDEN_WEIGHT_LIMIT },
+    { OUT_B, 1, false, 0.0f },
+};
+
+// --------------------------------------------------
+// Threads
+// --------------------------------------------------
+
+// Runs fn(thread, begin, end) on 'threads' threads over [0, count)
+template <typename F>
+static void parallelFor(int threads, size_t count, F fn) {
+    std::vector<std::thread> pool;
+    size_t step = (count + threads - 1) / threads;
+    for (int t = 1; t < threads; t++) {
+        size_t begin = std::min(count, t * step);
+        size_t end = std::min(count, begin + step);
+        pool.emplace_back(fn, t, begin, end);
+    }
+    fn(0, size_t(0), std::min(count, step));
+    for (auto& th : pool) {
+        th.join();
+    }
+}
+
+// Per-thread gradients. Only the feature-weight rows of the features its
+// positions contain are ever non-zero; they are listed in 'touchedRows'.
+struct GradientBuffer {
+    std::vector<float> grad;
+    std::vector<uint8_t> touched; // per feature
+    std::vector<int32_t> touchedRows;
+    double loss = 0.0;
+
+    GradientBuffer() : grad(PARAM_COUNT, 0.0f), touched(NNUE_INPUTS, 0) {
+    }
+};
+
+// --------------------------------------------------
+// Forward and backward pass
+// --------------------------------------------------
+static inline float clip01(float x) {
+    return std::min(std::max(x, 0.0f), 1.0f);
+}
+
+static inline bool inside01(float x) {
+    return x > 0.0f && x < 1.0f;
+}
+
+// Network output (units of NNUE_OUTPUT_SCALE centipawns) for one position.
+// 'features' holds 'count' features of the side to move, then of the other side.
+static float forward(const float* p, const int32_t* features, int count,
+    float acc[2][NNUE_L1], float x[2 * NNUE_L1], float z1[NNUE_L2], float h1[NNUE_L2],
+    float z2[NNUE_L3], float h2[NNUE_L3]) {
+    for (int side = 0; side < 2; side++) {
+        std::copy(p + FT_B, p + FT_B + NNUE_L1, acc[side]);
+        for (int k = 0; k < count; k++) {
+            const float* row = p + FT_W + static_cast<size_t>(features[side * count + k]) * NNUE_L1;
+            for (int j = 0; j < NNUE_L1; j++) acc[side][j] += row[j];
+        }
+        for (int j = 0; j < NNUE_L1; j++) x[side * NNUE_L1 + j] = clip01(acc[side][j]);
+    }
+
+    for (int o = 0; o < NNUE_L2; o++) {
+        const float* w = p + L2_W + o * 2 * NNUE_L1;
+        float sum = p[L2_B + o];
+        for (int i = 0; i < 2 * NNUE_L1; i++) sum += w[i] * x[i];
+        z1[o] = sum;
+        h1[o] = clip01(sum);
+    }
+    for (int o = 0; o < NNUE_L3; o++) {
+        const float* w = p + L3_W + o * NNUE_L2;
+        float sum = p[L3_B + o];
+        for (int i = 0; i < NNUE_L2; i++) sum += w[i] * h1[i];
+        z2[o] = sum;
+        h2[o] = clip01(sum);
+    }
+    float y = p[OUT_B];
+    for (int i = 0; i < NNUE_L3; i++) y += p[OUT_W + i] * h2[i];
+    return y;
+}
+
+// Adds the gradient of (sigmoid(prediction) - target)^2 to the buffer;
+// returns the loss
+static float trainPosition(const float* p, GradientBuffer& buffer, const int32_t* features, int count, float target) {
+    float acc[2][NNUE_L1], x[2 * NNUE_L1];
+    float z1[NNUE_L2], h1[NNUE_L2], z2[NNUE_L3], h2[NNUE_L3];
+    float y = forward(p, features, count, acc, x, z1, h1, z2, h2);
+
+    float prob = 1.0f / (1.0f + std::exp(-y * OUTPUT_TO_WDL));
+    float error = prob - target;
+    float dy = 2.0f * error * prob * (1.0f - prob) * OUTPUT_TO_WDL;
+
+    float* g = buffer.grad.data();
+    g[OUT_B] += dy;
+    float dz2[NNUE_L3];
+    for (int i = 0; i < NNUE_L3; i++) {
+        g[OUT_W + i] += dy * h2[i];
+        dz2[i] = inside01(z2[i]) ? dy * p[OUT_W + i] : 0.0f;
+    }
+
+    float dh1[NNUE_L2] = {};
+    for (int o = 0; o < NNUE_L3; o++) {
+        if (dz2[o] == 0.0f) continue;
+        g[L3_B + o] += dz2[o];
+        for (int i = 0; i < NNUE_L2; i++) {
+            g[L3_W + o * NNUE_L2 + i] += dz2[o] * h1[i];
+            dh1[i] += p[L3_W + o * NNUE_L2 + i] * dz2[o];
+        }
+    }
+
+    // Inputs clipped to 0 contribute no weight gradient, and neither they nor
+    // the ones clipped to 1 pass a gradient back to the accumulator
+    float dx[2 * NNUE_L1] = {};
+    for (int o = 0; o < NNUE_L2; o++) {
+        if (!inside01(z1[o]) || dh1[o] == 0.0f) continue;
+        float dz = dh1[o];
+        g[L2_B + o] += dz;
+        float* gw = g + L2_W + o * 2 * NNUE_L1;
+        const float* w = p + L2_W + o * 2 * NNUE_L1;
+        for (int i = 0; i < 2 * NNUE_L1; i++) {
+            gw[i] += dz * x[i];
+            dx[i] += w[i] * dz;
+        }
+    }
+
+    for (int side = 0; side < 2; side++) {
+        float* dacc = dx + side * NNUE_L1;
+        for (int j = 0; j < NNUE_L1; j++) {
+            if (!inside01(acc[side][j])) dacc[j] = 0.0f;
+            g[FT_B + j] += dacc[j];
+        }
+        for (int k = 0; k < count; k++) {
+            int feature = features[side * count + k];
+            float* row = g + FT_W + static_cast<size_t>(feature) * NNUE_L1;
+            for (int j = 0; j < NNUE_L1; j++) row[j] += dacc[j];
+            if (!buffer.touched[feature]) {
+                buffer.touched[feature] = 1;
+                buffer.touchedRows.push_back(feature);
+            }
+        }
+    }
+    return error * error;
+}
+
+// --------------------------------------------------
+// Initialization, checkpoints, export
+// --------------------------------------------------
+static void initParameters(std::vector<float>& p, uint32_t seed) {
+    std::mt19937 rng(seed);
+    auto fill = [&](size_t offset, size_t size, float range) {
+        std::uniform_real_distribution<float> dist(-range, range);
+        for (size_t i = 0; i < size; i++) p[offset + i] = dist(rng);
+    };
+    // About 30 features are active per side
+    fill(FT_W, FT_B - FT_W, 0.1f);
+    for (int j = 0; j < NNUE_L1; j++) p[FT_B + j] = 0.25f;
+    fill(L2_W, L2_B - L2_W, 1.0f / std::sqrt(2.0f * NNUE_L1));
+    fill(L2_B, NNUE_L2, 0.1f);
+    fill(L3_W, L3_B - L3_W, 1.0f / std::sqrt(static_cast<float>(NNUE_L2)));
+    fill(L3_B, NNUE_L3, 0.1f);
+    fill(OUT_W, NNUE_L3, 1.0f / std::sqrt(static_cast<float>(NNUE_L3)));
+    p[OUT_B] = 0.0f;
+}
+
+static const char CHECKPOINT_MAGIC[4] = { 'N', 'N', 'C', 'K' };
+
+struct TrainerState {
+    std::vector<float> params;
+    std::vector<float> m; // AdamW moments
+    std::vector<float> v;
+    uint64_t step = 0;
+};
+
+static bool saveCheckpoint(const std::string& path, const TrainerState& s) {
+    // Written next to the old one and renamed, so an interrupted write never
+    // destroys the last good checkpoint
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        uint32_t header[2] = { NNUE_FILE_VERSION, static_cast<uint32_t>(PARAM_COUNT) };
+        out.write(CHECKPOINT_MAGIC, 4);
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&s.step), sizeof(s.step));
+        for (const auto* v : { &s.params, &s.m, &s.v }) {
+            out.write(reinterpret_cast<const char*>(v->data()), v->size() * sizeof(float));
+        }
+        if (!out) {
+            std::cout << "Writing checkpoint " << tmp << " failed\n";
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+static bool loadCheckpoint(const std::string& path, TrainerState& s) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t header[2];
+    if (!in.read(magic, 4) || !in.read(reinterpret_cast<char*>(header), sizeof(header))
+        || std::memcmp(magic, CHECKPOINT_MAGIC, 4) != 0
+        || header[0] != NNUE_FILE_VERSION || header[1] != PARAM_COUNT) {
+        std::cout << path << " is not a checkpoint of this network architecture\n";
+        return false;
+    }
+    bool ok = static_cast<bool>(in.read(reinterpret_cast<char*>(&s.step), sizeof(s.step)));
+    for (auto* v : { &s.params, &s.m, &s.v }) {
+        v->resize(PARAM_COUNT);
+        ok = ok && in.read(reinterpret_cast<char*>(v->data()), v->size() * sizeof(float));
+    }
+    if (!ok) {
+        std::cout << path << " is truncated\n";
+    }
+    return ok;
+}
+
+template <typename T>
+static T quantize(float value, float scale) {
+    float q = std::round(value * scale);
+    float lo = static_cast<float>(std::numeric_limits<T>::lowest());
+    float hi = static_cast<float>(std::numeric_limits<T>::max());
+    return static_cast<T>(std::clamp(q, lo, hi));
+}
+
+static NnueNetwork quantizeNetwork(const std::vector<float>& p) {
+    const float act = static_cast<float>(NNUE_ACTIVATION_MAX);
+    const float weight = static_cast<float>(1 << NNUE_WEIGHT_SHIFT);
+    NnueNetwork net;
+    auto convert = [&](auto& out, size_t offset, size_t size, float scale) {
+        using T = typename std::remove_reference_t<decltype(out)>::value_type;
+        out.resize(size);
+        for (size_t i = 0; i < size; i++) out[i] = quantize<T>(p[offset + i], scale);
+    };
+    convert(net.ftWeights, FT_W, FT_B - FT_W, act);
+    convert(net.ftBiases, FT_B, NNUE_L1, act);
+    // Hidden sums are in activation * weight units, like their biases
+    convert(net.l2Weights, L2_W, L2_B - L2_W, weight);
+    convert(net.l2Biases, L2_B, NNUE_L2, act * weight);
+    convert(net.l3Weights, L3_W, L3_B - L3_W, weight);
+    convert(net.l3Biases, L3_B, NNUE_L3, act * weight);
+    convert(net.outWeights, OUT_W, NNUE_L3, weight);
+    net.outBias = quantize<int32_t>(p[OUT_B], act * weight);
+    return net;
+}
+
+// Mean difference in centipawns between the float network and its quantized
+// export over one batch, computed the way the engine does
+static double quantizationError(const std::vector<float>& p, const NnueNetwork& net, const TrainingBatch& batch) {
+    NnueDenseLayers dense;
+    packDenseLayers(net, dense);
+    float acc[2][NNUE_L1], x[2 * NNUE_L1];
+    float z1[NNUE_L2], h1[NNUE_L2], z2[NNUE_L3], h2[NNUE_L3];
+    alignas(64) int16_t quantized[2][NNUE_L1];
+
+    int samples = std::min(batch.size, 1000);
+    double total = 0.0;
+    for (int n = 0; n < samples; n++) {
+        const int32_t* features = batch.features.data() + batch.offsets[n];
+        int count = batch.counts[n];
+        float y = forward(p.data(), features, count, acc, x, z1, h1, z2, h2);
+
+        for (int side = 0; side < 2; side++) {
+            std::copy(net.ftBiases.begin(), net.ftBiases.end(), quantized[side]);
+            for (int k = 0; k < count; k++) {
+                const int16_t* row = net.ftWeights.data() + static_cast<size_t>(features[side * count + k]) * NNUE_L1;
+                for (int j = 0; j < NNUE_L1; j++) quantized[side][j] += row[j];
+            }
+        }
+        int32_t out = nnueForward(nnuePath(), dense, quantized[0], quantized[1]);
+        double cp = static_cast<double>(out) * NNUE_OUTPUT_SCALE / (NNUE_ACTIVATION_MAX << NNUE_WEIGHT_SHIFT);
+        total += std::abs(cp - y * NNUE_OUTPUT_SCALE);
+    }
+    return samples ? total / samples : 0.0;
+}
+
+// --------------------------------------------------
+// Training loop
+// --------------------------------------------------
+bool trainNetwork(const TrainerOptions& options) {
+    int threads = options.threads > 0 ? options.threads
+        : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    TrainingDataLoader loader(options.dataPath, options.batchSize, 64, 1);
+    if (!loader.isOpen()) {
+        return false;
+    }
+
+    TrainerState state;
+    std::ifstream existing(options.checkpointPath, std::ios::binary);
+    if (existing) {
+        existing.close();
+        if (!loadCheckpoint(options.checkpointPath, state)) {
+            return false;
+        }
+        std::cout << "Resuming from " << options.checkpointPath << " at batch " << state.step << "\n";
+    }
+    else {
+        state.params.resize(PARAM_COUNT);
+        initParameters(state.params, 1);
+        state.m.assign(PARAM_COUNT, 0.0f);
+        state.v.assign(PARAM_COUNT, 0.0f);
+    }
+
+    std::cout << "Training on " << loader.positionCount() << " positions, "
+        << threads << " threads, batches of " << options.batchSize << "\n";
+
+    std::vector<GradientBuffer> buffers(threads);
+    std::vector<float> grad(PARAM_COUNT, 0.0f);
+    std::vector<uint8_t> rowTouched(NNUE_INPUTS, 0);
+    std::vector<int32_t> rows;
+    TrainingBatch batch;
+
+    const float beta1 = 0.9f, beta2 = 0.999f, epsilon = 1e-8f;
+    double lossSum = 0.0;
+    int lossBatches = 0;
+    auto lastReport = std::chrono::steady_clock::now();
+
+    while (state.step < static_cast<uint64_t>(options.batches)) {
+        if (!loader.next(batch)) {
+            std::cout << "Reading training data failed\n";
+            return false;
+        }
+
+        // Gradients: each thread takes a slice of the batch
+        const float* p = state.params.data();
+        parallelFor(threads, batch.size, [&](int t, size_t begin, size_t end) {
+            GradientBuffer& buffer = buffers[t];
+            buffer.loss = 0.0;
+            for (size_t n = begin; n < end; n++) {
+                float target = options.scoreWeight * batch.scoreTarget[n]
+                    + (1.0f - options.scoreWeight) * batch.resultTarget[n];
+                buffer.loss += trainPosition(p, buffer, batch.features.data() + batch.offsets[n], batch.counts[n], target);
+            }
+        });
+
+        // Sum the buffers (clearing them on the way): the dense part in full,
+        // the feature weights only in the rows some thread touched
+        double loss = 0.0;
+        rows.clear();
+        for (auto& buffer : buffers) {
+            loss += buffer.loss;
+            for (int32_t row : buffer.touchedRows) {
+                if (!rowTouched[row]) {
+                    rowTouched[row] = 1;
+                    rows.push_back(row);
+                }
+                buffer.touched[row] = 0;
+            }
+            buffer.touchedRows.clear();
+        }
+        float scale = 1.0f / batch.size;
+        parallelFor(threads, rows.size(), [&](int, size_t begin, size_t end) {
+            for (size_t r = begin; r < end; r++) {
+                float* dst = grad.data() + FT_W + static_cast<size_t>(rows[r]) * NNUE_L1;
+                for (auto& buffer : buffers) {
+                    float* src = buffer.grad.data() + FT_W + static_cast<size_t>(rows[r]) * NNUE_L1;
+                    for (int j = 0; j < NNUE_L1; j++) {
+                        dst[j] += src[j] * scale;
+                        src[j] = 0.0f;
+                    }
+                }
+            }
+        });
+        for (auto& buffer : buffers) {
+            for (size_t i = FT_B; i < PARAM_COUNT; i++) {
+                grad[i] += buffer.grad[i] * scale;
+                buffer.grad[i] = 0.0f;
+            }
+        }
+
+        // AdamW over every parameter: untouched rows still follow their
+        // momentum and decay
+        state.step++;
+        float lr = options.learningRate;
+        if (state.step > static_cast<uint64_t>(options.batches) / 2) lr *= 0.3f;
+        if (state.step > static_cast<uint64_t>(options.batches) * 4 / 5) lr *= 0.3f;
+        float correction1 = 1.0f - std::pow(beta1, static_cast<float>(state.step));
+        float correction2 = 1.0f - std::pow(beta2, static_cast<float>(state.step));
+        for (const Tensor& tensor : TENSORS) {
+            parallelFor(tensor.size > 65536 ? threads : 1, tensor.size, [&](int, size_t begin, size_t end) {
+                float* params = state.params.data() + tensor.offset;
+                float* m = state.m.data() + tensor.offset;
+                float* v = state.v.data() + tensor.offset;
+                float* g = grad.data() + tensor.offset;
+                float decay = tensor.decay ? options.weightDecay : 0.0f;
+                for (size_t i = begin; i < end; i++) {
+                    m[i] = beta1 * m[i] + (1.0f - beta1) * g[i];
+                    v[i] = beta2 * v[i] + (1.0f - beta2) * g[i] * g[i];
+                    float update = (m[i] / correction1) / (std::sqrt(v[i] / correction2) + epsilon);
+                    params[i] -= lr * (update + decay * params[i]);
+                    if (tensor.limit > 0.0f) params[i] = std::clamp(params[i], -tensor.limit, tensor.limit);
+                    g[i] = 0.0f;
+                }
+            });
+        }
+        for (int32_t row : rows) {
+            rowTouched[row] = 0;
+        }
+
+        lossSum += loss / batch.size;
+        lossBatches++;
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - lastReport).count() >= 10.0 || state.step == static_cast<uint64_t>(options.batches)) {
+            std::cout << "Batch " << state.step << "/" << options.batches << "  epoch " << loader.epoch()
+                << "  loss " << lossSum / lossBatches << "  lr " << lr << std::endl;
+            lossSum = 0.0;
+            lossBatches = 0;
+            lastReport = now;
+        }
+
+        if (state.step % options.checkpointEvery == 0 || state.step == static_cast<uint64_t>(options.batches)) {
+            NnueNetwork net = quantizeNetwork(state.params);
+            if (!saveCheckpoint(options.checkpointPath, state) || !writeNetwork(options.networkPath, net)) {
+                return false;
+            }
+            std::cout << "Saved " << options.networkPath << " (quantization error "
+                << quantizationError(state.params, net, batch) << " cp)" << std::endl;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef TRAINER_H
+#define TRAINER_H
+
+#include <string>
+
+// --------------------------------------------------
+// NNUE trainer
+// --------------------------------------------------
+// Trains the network of Nnue.h on the CPU from packed training positions
+// (TrainingData.h). The network is kept in floats, in the units the engine
+// quantizes to (an activation of 1.0 is 127, a hidden weight of 1.0 is 64),
+// and weights are clamped to what the quantized format can hold, so the
+// exported file evaluates like the float network up to rounding.
+//
+// Each batch is split over the threads; every thread has its own gradient
+// buffer, and only the feature-weight rows its positions touched are summed
+// afterwards. The optimizer is AdamW. The target blends the search score and
+// the game result, both as a win probability for the side to move.
+
+struct TrainerOptions {
+    std::string dataPath;
+    std::string networkPath;    // quantized network, written at every checkpoint
+    std::string checkpointPath; // float weights and optimizer state; training
+                                // resumes from it if the file exists
+    int threads = 0;            // 0: one per core
+    int batchSize = 16384;
+    int batches = 2000;
+    int checkpointEvery = 200;  // batches
+    float learningRate = 1e-3f; // cut to 30% at half and again at 80% of the batches
+    float weightDecay = 1e-4f;
+    float scoreWeight = 0.75f;  // share of the search score in the target,
+                                // the rest is the game result
+};
+
+// Returns false if the data or a checkpoint could not be read or the
+// network could not be written
+bool trainNetwork(const TrainerOptions& options);
+
+#endif // TRAINER_H
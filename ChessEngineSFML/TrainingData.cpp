@@ -0,0 +1,263 @@
+#include "TrainingData.h"
+#include "Minimax.h"
+
+#include <algorithm> // for std::shuffle
+#include <cmath>     // for std::exp
+#include <cstdlib>   // for std::abs
+#include <iostream>
+
+// --------------------------------------------------
+// Packing
+// --------------------------------------------------
+PackedPosition packPosition(const Board& b, int score, int result, int ply) {
+    PackedPosition p = {};
+    p.occupied = b.colorBB[WHITE] | b.colorBB[BLACK];
+    int index = 0;
+    for (Bitboard x = p.occupied; x; index++) {
+        int sq = popLsb(x);
+        Piece piece = b.board[rowOf(sq)][colOf(sq)];
+        int code = piece.color * 6 + (piece.type - PAWN);
+        p.pieces[index / 2] |= static_cast<uint8_t>(code << (4 * (index & 1)));
+    }
+    p.score = static_cast<int16_t>(std::clamp(score, -32000, 32000));
+    p.result = static_cast<int8_t>(result);
+    p.sideToMove = static_cast<uint8_t>(b.sideToMove);
+    p.ply = static_cast<uint16_t>(std::min(ply, 65535));
+    return p;
+}
+
+// The piece bitboards of a record; false if it cannot be a position (more
+// than 32 pieces, a bad piece code, not one king per side)
+static bool decodePieces(const PackedPosition& p, Bitboard pieces[2][7]) {
+    if (popCount(p.occupied) > 32 || p.sideToMove > 1) {
+        return false;
+    }
+    for (int color = 0; color < 2; color++) {
+        for (int t = EMPTY; t <= KING; t++) {
+            pieces[color][t] = 0;
+        }
+    }
+    int index = 0;
+    for (Bitboard x = p.occupied; x; index++) {
+        int code = (p.pieces[index / 2] >> (4 * (index & 1))) & 15;
+        if (code >= 12) {
+            return false;
+        }
+        pieces[code / 6][PAWN + code % 6] |= squareBB(popLsb(x));
+    }
+    return popCount(pieces[WHITE][KING]) == 1 && popCount(pieces[BLACK][KING]) == 1;
+}
+
+void unpackPosition(const PackedPosition& p, Board& b) {
+    Bitboard pieces[2][7] = {};
+    if (!decodePieces(p, pieces)) {
+        for (int color = 0; color < 2; color++) {
+            for (int t = EMPTY; t <= KING; t++) {
+                pieces[color][t] = 0;
+            }
+        }
+    }
+    b.setPosition(pieces, static_cast<Color>(p.sideToMove & 1), 0, -1, 0);
+}
+
+// --------------------------------------------------
+// Self-play
+// --------------------------------------------------
+static constexpr int RANDOM_OPENING_PLIES = 8;
+static constexpr int MAX_GAME_PLIES = 400;
+static constexpr int ADJUDICATE_SCORE = 3000; // one side is winning for sure
+
+void generateTrainingData(const std::string& path, int games, int depth, const EvalParameters& evalParams) {
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    if (!out) {
+        std::cout << "Cannot open " << path << "\n";
+        return;
+    }
+
+    std::mt19937 rng(static_cast<uint32_t>(std::random_device{}()));
+    uint64_t written = 0;
+    int wins[3] = { 0, 0, 0 }; // Black, draw, White
+
+    for (int game = 0; game < games; game++) {
+        Board b;
+        clearTranspositionTable();
+
+        int ply = 0;
+        bool openingOver = true;
+        for (; ply < RANDOM_OPENING_PLIES; ply++) {
+            std::vector<Move> moves = b.generateLegalMoves();
+            if (moves.empty()) {
+                openingOver = false;
+                break;
+            }
+            b.makeMove(moves[rng() % moves.size()]);
+        }
+        if (!openingOver) {
+            game--; // mated during the random moves, try another opening
+            continue;
+        }
+
+        std::vector<PackedPosition> positions;
+        int result = 0;
+        for (; ply < MAX_GAME_PLIES; ply++) {
+            if (b.isDraw(0)) break;
+            std::vector<SearchLine> lines = searchMultiPV(b, depth, 1, evalParams);
+            if (lines.empty()) {
+                // Checkmate or stalemate
+                if (b.inCheck(b.sideToMove)) result = (b.sideToMove == WHITE) ? -1 : 1;
+                break;
+            }
+            const SearchLine& best = lines[0];
+            if (isMateScore(best.score) || std::abs(best.score) >= ADJUDICATE_SCORE) {
+                result = (best.score > 0) ? 1 : -1;
+                break;
+            }
+            if (!b.inCheck(b.sideToMove) && !b.isCapture(best.move) && best.move.promotion == EMPTY) {
+                positions.push_back(packPosition(b, best.score, 0, ply));
+            }
+            b.makeMove(best.move);
+        }
+
+        for (auto& p : positions) {
+            p.result = static_cast<int8_t>(result);
+        }
+        out.write(reinterpret_cast<const char*>(positions.data()), positions.size() * sizeof(PackedPosition));
+        written += positions.size();
+        wins[result + 1]++;
+
+        if ((game + 1) % 10 == 0 || game + 1 == games) {
+            std::cout << "Games " << (game + 1) << "/" << games << "  positions " << written
+                << "  +" << wins[2] << " =" << wins[1] << " -" << wins[0] << std::endl;
+        }
+    }
+    if (!out) {
+        std::cout << "Writing " << path << " failed\n";
+    }
+}
+
+// --------------------------------------------------
+// Streaming loader
+// --------------------------------------------------
+TrainingDataLoader::TrainingDataLoader(const std::string& path, int batchSize, int chunkBatches, uint32_t seed)
+    : in(path, std::ios::binary), batchSize(batchSize),
+    chunkSize(static_cast<size_t>(batchSize) * chunkBatches), rng(seed) {
+    if (!in) {
+        std::cout << "Cannot open training data " << path << "\n";
+        return;
+    }
+    in.seekg(0, std::ios::end);
+    fileRecords = static_cast<uint64_t>(in.tellg()) / sizeof(PackedPosition);
+    in.seekg(0);
+    open = fileRecords > 0;
+    if (!open) {
+        std::cout << path << " holds no training positions\n";
+    }
+}
+
+TrainingDataLoader::~TrainingDataLoader() {
+    if (pending.valid()) {
+        pending.wait();
+    }
+}
+
+// Reads the next chunk, wrapping around at the end of the file, and
+// shuffles it
+void TrainingDataLoader::fillChunk() {
+    size_t wanted = static_cast<size_t>(std::min<uint64_t>(chunkSize, fileRecords));
+    chunk.resize(wanted);
+    size_t have = 0;
+    while (have < wanted) {
+        in.read(reinterpret_cast<char*>(chunk.data() + have), (wanted - have) * sizeof(PackedPosition));
+        have += static_cast<size_t>(in.gcount()) / sizeof(PackedPosition);
+        if (have < wanted) {
+            in.clear();
+            in.seekg(0);
+            passes++;
+        }
+    }
+    std::shuffle(chunk.begin(), chunk.end(), rng);
+    chunkPos = 0;
+}
+
+bool TrainingDataLoader::decodeBatch(TrainingBatch& batch) {
+    batch.size = 0;
+    batch.features.clear();
+    batch.offsets.clear();
+    batch.counts.clear();
+    batch.scoreTarget.clear();
+    batch.resultTarget.clear();
+
+    Bitboard pieces[2][7];
+    int rejected = 0;
+    while (batch.size < batchSize) {
+        // Decode as many records as the batch still lacks
+        positions.clear();
+        records.clear();
+        while (static_cast<int>(records.size()) < batchSize - batch.size) {
+            if (chunkPos == chunk.size()) {
+                fillChunk();
+            }
+            const PackedPosition& p = chunk[chunkPos++];
+            if (!decodePieces(p, pieces)) {
+                // A corrupt file would otherwise loop here forever
+                if (++rejected > batchSize) return false;
+                continue;
+            }
+            positions.add(pieces, static_cast<Color>(p.sideToMove));
+            records.push_back(p);
+        }
+
+        positions.attackMaps(WHITE, attacks[WHITE]);
+        positions.attackMaps(BLACK, attacks[BLACK]);
+        positions.legalMoveCounts(moveCounts);
+
+        for (size_t i = 0; i < positions.size(); i++) {
+            Color us = positions.side(i);
+            Color them = (us == WHITE) ? BLACK : WHITE;
+            if ((attacks[them][i] & positions.pieces(i, us, KING)) || moveCounts[i] == 0) {
+                // So would a file of nothing but such positions
+                if (++rejected > batchSize) return false;
+                continue;
+            }
+
+            int count = 0;
+            batch.offsets.push_back(static_cast<uint32_t>(batch.features.size()));
+            for (Color perspective : { us, them }) {
+                int kingSq = lsb(positions.pieces(i, perspective, KING));
+                count = 0;
+                for (int color = 0; color < 2; color++) {
+                    for (int t = PAWN; t <= KING; t++) {
+                        Piece piece(static_cast<PieceType>(t), static_cast<Color>(color));
+                        for (Bitboard x = positions.pieces(i, piece.color, piece.type); x; count++) {
+                            batch.features.push_back(nnueFeature(perspective, kingSq, piece, popLsb(x)));
+                        }
+                    }
+                }
+            }
+            batch.counts.push_back(static_cast<uint8_t>(count));
+
+            const PackedPosition& p = records[i];
+            float sign = (us == WHITE) ? 1.0f : -1.0f;
+            batch.scoreTarget.push_back(1.0f / (1.0f + std::exp(-sign * p.score / WDL_SCALE)));
+            batch.resultTarget.push_back((sign * p.result + 1.0f) / 2.0f);
+            batch.size++;
+        }
+    }
+    return true;
+}
+
+bool TrainingDataLoader::next(TrainingBatch& batch) {
+    if (!open) {
+        return false;
+    }
+    if (!pending.valid()) {
+        pending = std::async(std::launch::async, [this] { return decodeBatch(prefetched); });
+    }
+    if (!pending.get()) {
+        open = false;
+        return false;
+    }
+    std::swap(batch, prefetched);
+    pending = std::async(std::launch::async, [this] { return decodeBatch(prefetched); });
+    return true;
+}
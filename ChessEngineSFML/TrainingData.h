@@ -0,0 +1,110 @@
+#ifndef TRAININGDATA_H
+#define TRAININGDATA_H
+
+#include "Board.h"
+#include "BoardBatch.h"
+#include "Evaluation.h" // we need EvalParameters
+
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <random>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------
+// Packed training positions
+// --------------------------------------------------
+// A training file is a plain array of 32-byte records, little-endian, with
+// no header, so files can be concatenated and shuffled with ordinary tools.
+// Only what the network sees is kept: castling and en passant rights do not
+// change its features.
+struct PackedPosition {
+    uint64_t occupied;  // one bit per occupied square
+    uint8_t pieces[16]; // 4 bits per occupied square, lowest square first:
+                        // color * 6 + piece type - PAWN
+    int16_t score;      // search score in centipawns, White's point of view
+    int8_t result;      // 1: White won, 0: draw, -1: Black won
+    uint8_t sideToMove;
+    uint16_t ply;       // game ply the position was reached at
+    uint16_t reserved;
+};
+
+static_assert(sizeof(PackedPosition) == 32, "training records are 32 bytes");
+
+PackedPosition packPosition(const Board& b, int score, int result, int ply);
+void unpackPosition(const PackedPosition& p, Board& b);
+
+// Plays 'games' games of the engine against itself at fixed depth and
+// appends one record per quiet position to 'path' (positions in check, or
+// whose best move captures or promotes, are skipped: their score depends on
+// the exchange rather than on the position). Each game opens with a few
+// random moves, and ends at mate, a draw, or once one side is clearly
+// winning. Evaluates with NNUE when it is on, so a network can
+// generate the data for its successor.
+void generateTrainingData(const std::string& path, int games, int depth, const EvalParameters& evalParams);
+
+// --------------------------------------------------
+// Streaming loader
+// --------------------------------------------------
+
+// Centipawns per unit of the logistic curve that turns a score into a win
+// probability (the trainer's prediction goes through the same curve)
+constexpr float WDL_SCALE = 400.0f;
+
+// Decoded positions in the form the trainer consumes: the NNUE feature
+// indices of each side (Nnue.h), side to move first
+struct TrainingBatch {
+    int size = 0;
+    std::vector<int32_t> features; // per position: 'count' features of the
+                                   // side to move, then 'count' of the other side
+    std::vector<uint32_t> offsets; // start of each position in 'features'
+    std::vector<uint8_t> counts;
+    std::vector<float> scoreTarget;  // win probability from the search score
+    std::vector<float> resultTarget; // 1, 0.5, 0 for the side to move
+};
+
+// Reads a training file a chunk at a time, shuffles each chunk and cuts it
+// into batches, looping over the file forever. The next batch is decoded on
+// a background thread while the current one trains. Records are decoded
+// into a BoardBatch, which also filters out positions that are not quiet
+// (side to move in check, or without a legal move) for files written by
+// other tools than generateTrainingData.
+class TrainingDataLoader {
+public:
+    TrainingDataLoader(const std::string& path, int batchSize, int chunkBatches, uint32_t seed);
+    ~TrainingDataLoader();
+
+    bool isOpen() const { return open; }
+    uint64_t positionCount() const { return fileRecords; }
+    int epoch() const { return passes; }
+
+    // The next batch; false if the file holds no positions
+    bool next(TrainingBatch& batch);
+
+private:
+    void fillChunk();
+    bool decodeBatch(TrainingBatch& batch);
+
+    std::ifstream in;
+    bool open = false;
+    uint64_t fileRecords = 0;
+    int batchSize;
+    size_t chunkSize;
+    int passes = 0;
+    std::mt19937 rng;
+
+    std::vector<PackedPosition> chunk;
+    size_t chunkPos = 0;
+
+    // Scratch space of decodeBatch
+    BoardBatch positions;
+    std::vector<PackedPosition> records; // the record of each position
+    std::vector<Bitboard> attacks[2];
+    std::vector<int> moveCounts;
+
+    TrainingBatch prefetched;
+    std::future<bool> pending;
+};
+
+#endif // TRAININGDATA_H
@@ -0,0 +1,47 @@
+#include "TranspositionTable.h"
+
+#include <algorithm> // for std::fill
+
+TranspositionTable::TranspositionTable(size_t sizeMB)
+    : mask(0) {
+    resize(sizeMB);
+}
+
+// Round the entry count down to a power of two so indexing is a single AND
+void TranspositionTable::resize(size_t sizeMB) {
+    size_t entries = (sizeMB * 1024 * 1024) / sizeof(TTEntry);
+    size_t count = 1;
+    while (count * 2 <= entries) {
+        count *= 2;
+    }
+    table.assign(count, TTEntry());
+    mask = count - 1;
+}
+
+void TranspositionTable::clear() {
+    std::fill(table.begin(), table.end(), TTEntry());
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    const TTEntry& slot = table[key & mask];
+    if (slot.bound != BOUND_NONE && slot.key == key) {
+        entry = slot;
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int score, BoundType bound, const Move& bestMove) {
+    TTEntry& slot = table[key & mask];
+
+    // Keep a deeper result for the same position unless the new one is exact
+    if (slot.key == key && slot.depth > depth && bound != BOUND_EXACT) {
+        return;
+    }
+
+    slot.key = key;
+    slot.depth = depth;
+    slot.score = score;
+    slot.bound = bound;
+    slot.bestMove = bestMove;
+}
@@ -0,0 +1,49 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include "ChessTypes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Kind of score stored in an entry
+enum BoundType {
+    BOUND_NONE = 0,
+    BOUND_EXACT,  // score is the exact minimax value
+    BOUND_LOWER,  // search failed high: value >= score
+    BOUND_UPPER   // search failed low:  value <= score
+};
+
+// One slot of the table. Scores are from the side to move's point of view.
+struct TTEntry {
+    uint64_t key;
+    int score;
+    int depth;
+    BoundType bound;
+    Move bestMove;
+
+    TTEntry()
+        : key(0), score(0), depth(-1), bound(BOUND_NONE), bestMove() {
+    }
+};
+
+// Simple always-replace hash table indexed by the low bits of the Zobrist key
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t sizeMB = 16);
+
+    void resize(size_t sizeMB);
+    void clear();
+
+    // Returns true and fills 'entry' when the key is present
+    bool probe(uint64_t key, TTEntry& entry) const;
+
+    void store(uint64_t key, int depth, int score, BoundType bound, const Move& bestMove);
+
+private:
+    std::vector<TTEntry> table;
+    size_t mask;
+};
+
+#endif // TRANSPOSITIONTABLE_H
@@ -1,9 +1,15 @@
 #include <SFML/Graphics.hpp>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
+#include "Bench.h"
 #include "Board.h"
 #include "Evaluation.h"
 #include "Minimax.h"
+#include "Nnue.h"
+#include "Trainer.h"
+#include "TrainingData.h"
 
 // --------------------------------------------------
 // SFML GUI Helpers
@@ -45,21 +51,97 @@ sf::CircleShape createPieceShape(const Piece& p) {
 // --------------------------------------------------
 // Main
 // --------------------------------------------------
-int main() {
-    // Optionally: run a brief "training" to find better eval parameters.
-    // If you want to skip it (since it can be slow), just comment it out.
-    std::cout << "Starting optional evolutionary parameter training...\n";
-    EvalParameters bestParams = trainEvalParameters(
-        /*generations=*/2,
-        /*populationSize=*/6,
-        /*testPositionsCount=*/2
-    );
-    std::cout << "Training done. Best parameters found:\n"
-        << "  Pawn: " << bestParams.pawnValue << "\n"
-        << "  Knight: " << bestParams.knightValue << "\n"
-        << "  Bishop: " << bestParams.bishopValue << "\n"
-        << "  Rook: " << bestParams.rookValue << "\n"
-        << "  Queen: " << bestParams.queenValue << "\n";
+int main(int argc, char* argv[]) {
+    // Options first, then the mode:
+    // "--nnue <file>": evaluate with that network
+    // "--evalcache <MB>": size of the static eval cache
+    while (argc > 2 && std::string(argv[1]).rfind("--", 0) == 0) {
+        std::string option = argv[1];
+        if (option == "--nnue") {
+            if (!loadNetwork(argv[2])) {
+                return 1;
+            }
+            setUseNnue(true);
+        }
+        else if (option == "--evalcache") {
+            setEvalCacheSize(std::atoi(argv[2]));
+        }
+        else {
+            std::cout << "Unknown option " << option << "\n";
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    // "bench [depth] [probcut margin]": search the bench positions and exit
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        int depth = (argc > 2) ? std::atoi(argv[2]) : 6;
+        if (argc > 3) {
+            setProbCutMargin(std::atoi(argv[3]));
+        }
+        runBench(depth, DEFAULT_EVAL_PARAMETERS);
+        return 0;
+    }
+
+    // "see": time the static exchange evaluation and exit
+    if (argc > 1 && std::string(argv[1]) == "see") {
+        runSeeBench(DEFAULT_EVAL_PARAMETERS);
+        return 0;
+    }
+
+    // "perft <depth> [fen]": count leaf nodes of the legal move tree and exit
+    if (argc > 2 && std::string(argv[1]) == "perft") {
+        std::string fen;
+        for (int i = 3; i < argc; i++) {
+            fen += std::string(argv[i]) + " ";
+        }
+        runPerft(std::atoi(argv[2]), fen);
+        return 0;
+    }
+
+    // "analyze <depth> <lines> [fen]": print the best lines with their
+    // scores and PVs and exit
+    if (argc > 3 && std::string(argv[1]) == "analyze") {
+        std::string fen;
+        for (int i = 4; i < argc; i++) {
+            fen += std::string(argv[i]) + " ";
+        }
+        runAnalysis(std::atoi(argv[2]), std::atoi(argv[3]), fen, DEFAULT_EVAL_PARAMETERS);
+        return 0;
+    }
+
+    // "cpu": show the dispatched CPU paths, self-test and time them, then exit
+    if (argc > 1 && std::string(argv[1]) == "cpu") {
+        return runCpuBench() ? 0 : 1;
+    }
+
+    // "nnue": time the NNUE evaluation on each CPU path and exit
+    if (argc > 1 && std::string(argv[1]) == "nnue") {
+        runNnueBench();
+        return 0;
+    }
+
+    // "selfplay <file> <games> [depth]": append training positions from
+    // engine self-play to <file> and exit
+    if (argc > 3 && std::string(argv[1]) == "selfplay") {
+        int depth = (argc > 4) ? std::atoi(argv[4]) : 6;
+        generateTrainingData(argv[2], std::atoi(argv[3]), depth, DEFAULT_EVAL_PARAMETERS);
+        return 0;
+    }
+
+    // "train <data file> <network file> [batches] [threads]": train a network
+    // on the CPU and exit. <network file>.ckpt holds the training state; an
+    // interrupted run started again resumes from it.
+    if (argc > 3 && std::string(argv[1]) == "train") {
+        TrainerOptions options;
+        options.dataPath = argv[2];
+        options.networkPath = argv[3];
+        options.checkpointPath = options.networkPath + ".ckpt";
+        if (argc > 4) options.batches = std::atoi(argv[4]);
+        if (argc > 5) options.threads = std::atoi(argv[5]);
+        return trainNetwork(options) ? 0 : 1;
+    }
 
     // Create an SFML window
     sf::RenderWindow window(sf::VideoMode(640, 640), "Chess Engine (GUI)");
@@ -101,7 +183,9 @@ int main() {
                         if (isDragging) {
                             // Attempt user move
                             Move userMove(dragFrom.x, dragFrom.y, row, col);
-                            std::vector<Move> legalMoves = board.generateMoves();
+                            // Promotions are generated queen first, so a
+                            // pawn dragged to the last rank becomes a queen
+                            std::vector<Move> legalMoves = board.generateLegalMoves();
                             bool found = false;
                             for (auto& m : legalMoves) {
                                 if (m.fromRow == userMove.fromRow &&
@@ -124,7 +208,7 @@ int main() {
         // If it's AI's turn (BLACK), let the AI move
         if (board.sideToMove == BLACK) {
             int searchDepth = 4;
-            Move best = findBestMove(board, searchDepth, bestParams);
+            Move best = findBestMove(board, searchDepth, DEFAULT_EVAL_PARAMETERS);
             if (!(best.fromRow == best.toRow && best.fromCol == best.toCol)) {
                 board.makeMove(best);
             }